@@ -0,0 +1,103 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "belief.h"
+#include "player.h"
+
+// the cards of every rank either player has booked
+static card_mask_t booked_cards(const player_t* const observer) {
+    card_mask_t           booked = 0;
+    const player_t* const seats[2] = {observer, observer->opponent};
+    for (range(seat, 0, 2, 1)) {
+        if (seats[seat] == NULL) continue;
+        for (range(idx, 0, RULES_TO_WIN, 1))
+            if (seats[seat]->books[idx] != RANK_NULL)
+                booked |= card_mask_rank(seats[seat]->books[idx] - RANK_2);
+    }
+    return booked;
+}
+
+// belief_chance, given the cards the opponent can't have
+static double chance_of(
+    const player_t* const opponent,
+    card_mask_t           booked,
+    card_mask_t           mine,
+    int                   slot  //
+) {
+    const belief_t* seen = &opponent->seen;
+    card_mask_t     rank = card_mask_rank(slot);
+    if (booked & rank) return 0;
+
+    card_mask_t known = seen->known & ~booked & ~mine;
+    if ((known & rank) || (seen->asked >> slot & 1)) return 1;
+
+    // the unknown slots the rank could be in, each filled from `pool`
+    // unseen cards, so none are of the rank with chance
+    // C(pool - of_rank, slots) / C(pool, slots)
+    int slots = opponent->hand.length - __builtin_popcountll(known);
+    int draws = seen->draws >> 4 * slot & BELIEF_NO_INFO;
+    if (draws < BELIEF_NO_INFO && draws < slots) slots = draws;
+
+    card_mask_t unseen = CARD_MASK_ALL & ~booked & ~mine & ~known;
+    int         pool = __builtin_popcountll(unseen);
+    int         of_rank = __builtin_popcountll(unseen & rank);
+    if (of_rank == 0 || slots <= 0) return 0;
+    if (slots >= pool) return 1;
+
+    double none = 1;
+    for (range(idx, 0, of_rank, 1))
+        none *= (double)(pool - slots - idx) / (pool - idx);
+    return 1 - none;
+}
+
+double belief_chance(const player_t* const observer, rank_t rank) {
+    if (observer->opponent == NULL) return 0;
+    return chance_of(
+        observer->opponent,
+        booked_cards(observer),
+        hand_mask(&observer->hand),
+        rank - RANK_2);
+}
+
+rank_t belief_best_ask(const player_t* const observer) {
+    if (observer->hand.length == 0 || observer->opponent == NULL)
+        return RANK_NULL;
+
+    card_mask_t booked = booked_cards(observer);
+    card_mask_t mine = hand_mask(&observer->hand);
+
+    int    best = -1, best_held = 0;
+    double best_chance = -1;
+    for (range(slot, 0, 13, 1)) {
+        int held = __builtin_popcountll(mine & card_mask_rank(slot));
+        if (held == 0) continue;
+
+        double chance = chance_of(observer->opponent, booked, mine, slot);
+        if (chance > best_chance ||
+            (chance == best_chance && held > best_held)) {
+            best = slot;
+            best_held = held;
+            best_chance = chance;
+        }
+    }
+    return best + RANK_2;
+}
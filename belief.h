@@ -0,0 +1,112 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "card.h"
+
+/** === [ Beliefs ] ===
+ *
+ * What the table has seen of one player's hand, kept on that player
+ * and updated by play_turn from the things everybody sees happen: the
+ * ranks the player asks for, the cards handed to them, the asks they
+ * have to say "go fish" to and the cards they draw.
+ *
+ * That's the cards certainly in the hand (a card_mask_t), the ranks
+ * the player is known to hold some of (they asked for it), and per
+ * rank how many cards the player has drawn since it was last seen to
+ * hold none of it, 4 bits a rank packed into one word so a draw bumps
+ * all 13 counts with a few instructions. A count of BELIEF_NO_INFO
+ * means the rank hasn't been ruled out recently enough to matter.
+ *
+ * The chance of a rank then comes from treating every unseen card
+ * (not in the observer's hand, not booked, not known to be in this
+ * one) as equally likely to fill a slot it could be in: any unknown
+ * slot of the hand for a rank that hasn't been ruled out, only the
+ * slots drawn into since otherwise. That makes it a hypergeometric
+ * draw.
+ */
+
+#define BELIEF_NO_INFO 15
+#define BELIEF_LANES   0x1111111111111ull  // the low bit of each count
+
+typedef struct {
+    card_mask_t known;  // certainly in the hand
+    uint64_t    draws;  // 4 bits a rank slot, see above
+    uint16_t    asked;  // rank slots asked for, so held at least once
+} belief_t;
+
+struct _player;
+
+/**
+ * @brief nothing seen yet
+ */
+static inline void belief_reset(belief_t* const seen) {
+    *seen = (belief_t){.draws = BELIEF_LANES * BELIEF_NO_INFO};
+}
+
+/**
+ * @brief the player drew an unseen card from the deck
+ */
+static inline void belief_drew(belief_t* const seen) {
+    // add one to every count that isn't already saturated
+    uint64_t draws = seen->draws;
+    uint64_t full = draws & draws >> 1 & draws >> 2 & draws >> 3;
+    seen->draws = draws + (BELIEF_LANES & ~full);
+}
+
+/**
+ * @brief the player asked for a rank and was handed `given` (maybe
+ * none), so they hold those and at least one more of the rank
+ */
+static inline void belief_asked(
+    belief_t* const seen,
+    rank_t          rank,
+    card_mask_t     given  //
+) {
+    seen->known |= given;
+    seen->asked |= 1 << (rank - RANK_2);
+}
+
+/**
+ * @brief the player was asked for a rank and now holds none of it,
+ * either they had none or they handed it all over
+ */
+static inline void belief_none_of(belief_t* const seen, rank_t rank) {
+    int slot = rank - RANK_2;
+    seen->known &= ~card_mask_rank(slot);
+    seen->asked &= ~(1 << slot);
+    seen->draws &= ~((uint64_t)BELIEF_NO_INFO << 4 * slot);
+}
+
+/**
+ * @brief the chance, as far as `observer` can tell, that its opponent
+ * holds at least one card of `rank`
+ */
+double belief_chance(const struct _player* const observer, rank_t rank);
+
+/**
+ * @brief the rank in the observer's hand its opponent is most likely
+ * to hold, ties going to the rank the observer has more of, RANK_NULL
+ * for an empty hand
+ */
+rank_t belief_best_ask(const struct _player* const observer);
@@ -0,0 +1,343 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/wait.h>
+
+#include "bot.h"
+#include "sim.h"
+
+static err_t write_all(int fd, const void* const buf, size_t len) {
+    const char* pos = buf;
+    while (len > 0) {
+        ssize_t n = write(fd, pos, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return ERROR;
+        pos += n;
+        len -= n;
+    }
+    return SUCCESS;
+}
+
+// reads exactly len bytes, a timeout_ms of -1 waits forever
+static err_t read_all(int fd, void* const buf, size_t len, int timeout_ms) {
+    char*    pos = buf;
+    uint64_t deadline = sim_now_ns() + (uint64_t)timeout_ms * 1000000;
+    while (len > 0) {
+        if (timeout_ms >= 0) {
+            uint64_t now = sim_now_ns();
+            if (now >= deadline) return ERROR;
+            // rounded up, so poll never gives up short of the deadline
+            int wait_ms = (deadline - now + 999999) / 1000000;
+            struct pollfd pfd = {.fd = fd, .events = POLLIN};
+            int           ready = poll(&pfd, 1, wait_ms);
+            if (ready < 0 && errno == EINTR) continue;
+            if (ready <= 0) return ERROR;
+        }
+
+        ssize_t n = read(fd, pos, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return ERROR;
+        pos += n;
+        len -= n;
+    }
+    return SUCCESS;
+}
+
+bot_t* bot_spawn(const char* const cmd) {
+    int to[2], from[2];
+    if (pipe2(to, O_CLOEXEC) != 0 || pipe2(from, O_CLOEXEC) != 0)
+        ohcrap("unable to create the pipes to a bot");
+
+    // a bot that dies is reported by the failed write, not a signal
+    signal(SIGPIPE, SIG_IGN);
+
+    pid_t pid = fork();
+    if (pid < 0) ohcrap("unable to fork a bot");
+    if (pid == 0) {
+        // dup2 clears close-on-exec on the copies
+        dup2(to[0], STDIN_FILENO);
+        dup2(from[1], STDOUT_FILENO);
+        execl("/bin/sh", "sh", "-c", cmd, (char*)NULL);
+        _exit(127);
+    }
+
+    close(to[0]);
+    close(from[1]);
+
+    bot_t* bot = malloc(sizeof(bot_t));
+    *bot = (bot_t){.pid = pid, .to_fd = to[1], .from_fd = from[0]};
+    return bot;
+}
+
+void bot_close(bot_t* const bot) {
+    // closing its stdin is the bot's cue to exit
+    close(bot->to_fd);
+    close(bot->from_fd);
+    waitpid(bot->pid, NULL, 0);
+    free(bot);
+}
+
+void bot_observe(const player_t* const player, bot_obs_t* const obs) {
+    memset(obs, 0, sizeof(*obs));
+
+    for (hand_node_t node = player->hand.head; node != NULL;
+         node = node->next)
+        obs->hand[card_idx_slot(node->card)]++;
+
+    for (range(idx, 0, RULES_TO_WIN, 1)) {
+        if (player->books[idx] != RANK_NULL)
+            obs->books[player->books[idx] - RANK_2] = 1;
+        if (player->opponent != NULL &&
+            player->opponent->books[idx] != RANK_NULL)
+            obs->books[player->opponent->books[idx] - RANK_2] = 2;
+    }
+
+    obs->deck = player->deck != NULL ? player->deck->remaining : 0;
+    obs->opponent_cards =
+        player->opponent != NULL ? player->opponent->hand.length : 0;
+}
+
+void bot_decide(
+    bot_t* const           bot,
+    const bot_obs_t* const obs,
+    rank_t* const          ranks,
+    uint16_t               count  //
+) {
+    if (count == 0 || count > BOT_BATCH_MAX)
+        ohcrap("bot batch size out of range");
+
+    // the header and body go out in a single write
+    uint8_t request[2 + sizeof(bot_obs_t) * BOT_BATCH_MAX];
+    request[0] = count & 0xff;
+    request[1] = count >> 8;
+    memcpy(&request[2], obs, sizeof(bot_obs_t) * count);
+    if (!write_all(bot->to_fd, request, 2 + sizeof(bot_obs_t) * count))
+        ohcrap("unable to write to the bot, did it exit?");
+
+    uint8_t answer[BOT_BATCH_MAX];
+    if (!read_all(bot->from_fd, answer, count, BOT_TIMEOUT_MS))
+        ohcrap("the bot did not answer in time");
+
+    for (range(idx, 0, count, 1)) {
+        if (answer[idx] >= 13 || obs[idx].hand[answer[idx]] == 0)
+            ohcrap("the bot asked for a rank it does not hold");
+        ranks[idx] = answer[idx] + RANK_2;
+    }
+}
+
+rank_t bot_read_rank(player_t* player) {
+    bot_obs_t obs;
+    rank_t    rank;
+    bot_observe(player, &obs);
+    bot_decide(player->ctx, &obs, &rank, 1);
+    return rank;
+}
+
+/* === [ batched games ] === */
+
+typedef struct {
+    player_t        bot;
+    player_t        compy;
+    deck_t          deck;
+    // the rank the bot answered for this table in the last batched
+    // request, asked when table_apply plays the bot's turn
+    rank_t          pending;
+    const player_t* winner;   // nullable, set once the game is over
+} bot_table_t;
+
+static rank_t table_read_rank(player_t* player) {
+    return ((bot_table_t*)player->ctx)->pending;
+}
+
+/**
+ * @brief play turns until the bot has to pick a rank
+ *
+ * @param compy_first whether the computer moves before the bot
+ * @return false if the game ended along the way
+ */
+static bool table_advance(bot_table_t* const t, bool compy_first) {
+    for (;;) {
+        if (!compy_first && play_turn_draw_up(&t->bot, &t->deck))
+            return true;
+        compy_first = false;
+
+        turn_result_t result;
+        do result = play_turn(
+            &t->compy, &t->bot, &t->deck, &t->bot, &t->compy);
+        while (result == TURN_EXTRA);
+
+        if (result == TURN_WON) {
+            t->winner = &t->compy;
+            return false;
+        }
+    }
+}
+
+static bool table_start(bot_table_t* const t, bool compy_first) {
+    player_t bot = player_init("Bot", false, &table_read_rank);
+    player_t compy = player_init("Compy", false, &play_compy_turn);
+    memcpy(&t->bot, &bot, sizeof(bot));
+    memcpy(&t->compy, &compy, sizeof(compy));
+    t->bot.ctx = t;
+    t->winner = NULL;
+    player_seat(&t->bot, &t->compy, &t->deck);
+
+    deck_init(&t->deck);
+    deck_shuffle(&t->deck);
+    player_deal_cards(&t->bot, &t->deck, RULES_HAND);
+    player_deal_cards(&t->compy, &t->deck, RULES_HAND);
+
+    return table_advance(t, compy_first);
+}
+
+// plays the bot's decided turn, returns false if the game ended
+static bool table_apply(bot_table_t* const t, rank_t rank) {
+    t->pending = rank;
+    switch (play_turn(&t->bot, &t->compy, &t->deck, &t->bot, &t->compy)) {
+        case TURN_WON:
+            t->winner = &t->bot;
+            return false;
+        case TURN_EXTRA:
+            return table_advance(t, false);
+        case TURN_NEXT:
+        default:
+            return table_advance(t, true);
+    }
+}
+
+int bot_play(const char* const cmd, int games, int batch) {
+    if (games <= 0) ohcrap("the number of games must be positive");
+    if (batch <= 0 || batch > BOT_BATCH_MAX) batch = BOT_BATCH_MAX;
+    if (batch > games) batch = games;
+
+    bot_t*       bot = bot_spawn(cmd);
+    bot_table_t* tables = calloc(batch, sizeof(bot_table_t));
+    bot_obs_t*   obs = malloc(sizeof(bot_obs_t) * batch);
+    rank_t*      ranks = malloc(sizeof(rank_t) * batch);
+    int*         waiting = malloc(sizeof(int) * batch);
+
+    int started = 0, finished = 0, bot_wins = 0;
+    int decisions = 0, requests = 0;
+
+    // every table slot runs games back to back, who moves first
+    // alternates with the game number so neither seat is favored
+    for (range(idx, 0, batch, 1)) {
+        bool active = table_start(&tables[idx], started % 2 == 1);
+        started++;
+        while (!active) {
+            bot_wins += tables[idx].winner == &tables[idx].bot;
+            finished++;
+            player_cleanup(&tables[idx].bot);
+            player_cleanup(&tables[idx].compy);
+            if (started == games) break;
+            active = table_start(&tables[idx], started % 2 == 1);
+            started++;
+        }
+    }
+
+    double start = sim_now();
+    while (finished < games) {
+        // every table still playing is waiting on the bot
+        uint16_t count = 0;
+        for (range(idx, 0, batch, 1)) {
+            if (tables[idx].winner != NULL) continue;
+            bot_observe(&tables[idx].bot, &obs[count]);
+            waiting[count++] = idx;
+        }
+        if (count == 0) break;
+
+        bot_decide(bot, obs, ranks, count);
+        decisions += count;
+        requests++;
+
+        for (range(w, 0, count, 1)) {
+            bot_table_t* t = &tables[waiting[w]];
+            bool         active = table_apply(t, ranks[w]);
+            while (!active) {
+                bot_wins += t->winner == &t->bot;
+                finished++;
+                player_cleanup(&t->bot);
+                player_cleanup(&t->compy);
+                if (started == games) break;
+                active = table_start(t, started % 2 == 1);
+                started++;
+            }
+        }
+    }
+    double secs = sim_now() - start;
+
+    printf(
+        "%i games, bot won %i (%.1f%%)\n"
+        "%i decisions in %i requests (%.1f per request), "
+        "%.0f decisions/sec\n",
+        finished,
+        bot_wins,
+        100.0 * bot_wins / finished,
+        decisions,
+        requests,
+        requests ? (double)decisions / requests : 0.0,
+        secs > 0 ? decisions / secs : 0.0);
+
+    bot_close(bot);
+    free(tables);
+    free(obs);
+    free(ranks);
+    free(waiting);
+    return 0;
+}
+
+/* === [ reference bot ] === */
+
+uint8_t bot_example_pick(const bot_obs_t* const obs) {
+    uint8_t best = 0;
+    for (range(r, 1, 13, 1))
+        if (obs->hand[r] >= obs->hand[best]) best = r;
+    return best;
+}
+
+int bot_example_main() {
+    for (;;) {
+        uint8_t header[2];
+        if (!read_all(STDIN_FILENO, header, 2, -1)) return 0;
+        uint16_t count = header[0] | (header[1] << 8);
+        if (count == 0 || count > BOT_BATCH_MAX) return 1;
+
+        bot_obs_t obs[BOT_BATCH_MAX];
+        if (!read_all(STDIN_FILENO, obs, sizeof(bot_obs_t) * count, -1))
+            return 1;
+
+        uint8_t answer[BOT_BATCH_MAX];
+        for (range(idx, 0, count, 1))
+            answer[idx] = bot_example_pick(&obs[idx]);
+
+        if (!write_all(STDOUT_FILENO, answer, count)) return 1;
+    }
+}
@@ -0,0 +1,124 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <sys/types.h>
+
+#include "gofish.h"
+
+/** === [ Bot protocol ] ===
+ *
+ * A bot is any program that reads requests on stdin and writes answers
+ * on stdout, both binary and unbuffered on our end:
+ *
+ *   request: uint16_t count (little endian) then count bot_obs_t
+ *   answer:  count bytes, one rank index (0 = the 2s .. 12 = aces) per
+ *            observation, in the same order
+ *
+ * Several games are asked about in one request when they are played
+ * side by side, so one write and one read cover a whole batch of
+ * decisions. Answering with a rank not in the hand, or taking longer
+ * than the move timeout, ends the run.
+ */
+
+#define BOT_BATCH_MAX   256   // observations per request at most
+#define BOT_TIMEOUT_MS  1000  // how long a bot may take per request
+
+/**
+ * @brief everything a bot is allowed to see when picking a rank, ranks
+ * are indexed from 0 (the 2s) to 12 (the aces)
+ */
+typedef struct __attribute__((__packed__)) {
+    uint8_t hand[13];        // number of cards of each rank in hand
+    uint8_t books[13];       // 0 unbooked, 1 the bot's, 2 the opponent's
+    uint8_t deck;            // cards left to draw
+    uint8_t opponent_cards;  // size of the opponent's hand
+    uint8_t _reserved[4];    // zero, pads the struct to 32 bytes
+} bot_obs_t;
+
+/**
+ * @brief a running bot process and the pipes to it
+ */
+typedef struct {
+    pid_t pid;
+    int   to_fd;    // the bot's stdin
+    int   from_fd;  // the bot's stdout
+} bot_t;
+
+/**
+ * @brief start a bot, `cmd` is run with /bin/sh -c
+ *
+ * @exception exits if the process cannot be started
+ */
+bot_t* bot_spawn(const char* const cmd);
+
+/**
+ * @brief close the bot's pipes and wait for it to exit
+ */
+void bot_close(bot_t* const);
+
+/**
+ * @brief fill in what `player` can see of the table
+ */
+void bot_observe(const player_t* const player, bot_obs_t* const obs);
+
+/**
+ * @brief ask the bot about `count` observations with one request
+ *
+ * @param ranks written with one chosen rank per observation
+ * @exception exits on a timeout, a dead bot, or a rank out of range
+ */
+void bot_decide(
+    bot_t* const           bot,
+    const bot_obs_t* const obs,
+    rank_t* const          ranks,
+    uint16_t               count);
+
+/**
+ * @brief read_rank backed by the bot_t in the player's ctx, one
+ * observation per request
+ */
+rank_t bot_read_rank(player_t* player);
+
+/**
+ * @brief play `games` games of the bot against the computer with up to
+ * `batch` games in flight, and report the results
+ *
+ * @return int process exit code
+ */
+int bot_play(const char* const cmd, int games, int batch);
+
+/**
+ * @brief the reference bot's choice: the rank it holds the most of
+ *
+ * @return uint8_t a rank index, 0 (the 2s) to 12 (the aces)
+ */
+uint8_t bot_example_pick(const bot_obs_t* const obs);
+
+/**
+ * @brief a reference bot speaking the protocol on stdin/stdout, it asks
+ * for whichever rank it holds the most of
+ *
+ * @return int process exit code
+ */
+int bot_example_main();
@@ -0,0 +1,192 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "canon.h"
+#include "sim.h"
+#include "endgame.h"
+
+#define CANON_TIMING_SECS 0.25  // time canon_masks for at least this
+
+// a position as the player about to ask sees it, plus the hidden hand
+typedef struct {
+    card_mask_t masks[2];  // the mover's hand, the opponent's
+} state_t;
+
+typedef struct {
+    state_t* states;
+    long     count, capacity;
+} recorder_t;
+
+static int compare_states(const void* a, const void* b) {
+    return memcmp(a, b, sizeof(state_t));
+}
+
+// the number of distinct states, sorts them
+static long distinct(state_t* states, long count) {
+    if (count == 0) return 0;
+    qsort(states, count, sizeof(state_t), &compare_states);
+    long unique = 1;
+    for (long idx = 1; idx < count; idx++)
+        unique += compare_states(&states[idx - 1], &states[idx]) != 0;
+    return unique;
+}
+
+// distinct states before and after canonicalizing, keeps them raw
+static void report(const char* label, state_t* states, long count) {
+    state_t* canonical = malloc(count * sizeof(state_t));
+    memcpy(canonical, states, count * sizeof(state_t));
+    for (long idx = 0; idx < count; idx++)
+        canon_masks(canonical[idx].masks, 2);
+
+    long raw = distinct(states, count);
+    long folded = distinct(canonical, count);
+    printf(
+        "  %-26s %9li distinct, %8li canonical, %5.2fx fewer\n",
+        label,
+        raw,
+        folded,
+        (double)raw / folded);
+    free(canonical);
+}
+
+// every hand of `size` cards, with `other` cards in a second hand
+static long every_hand(state_t* into, int size, int other) {
+    long        count = 0;
+    card_mask_t last = (card_mask_t)1 << 52;
+    // Gosper's hack, every 52 bit mask with `size` bits set in order
+    for (card_mask_t mine = ((card_mask_t)1 << size) - 1; mine < last;) {
+        if (other == 0) {
+            into[count++] = (state_t){{mine, 0}};
+        } else {
+            card_mask_t rest = CARD_MASK_ALL & ~mine;
+            for (range(a, 0, 52, 1))
+                for (range(b, a + 1, 52, 1)) {
+                    card_mask_t theirs = (card_mask_t)1 << a |
+                                         (card_mask_t)1 << b;
+                    if ((theirs & rest) == theirs)
+                        into[count++] = (state_t){{mine, theirs}};
+                }
+        }
+        card_mask_t low = mine & -mine, ripple = mine + low;
+        mine = (((ripple ^ mine) >> 2) / low) | ripple;
+    }
+    return count;
+}
+
+static rank_t recording_read_rank(player_t* player) {
+    recorder_t* recorder = player->ctx;
+    if (recorder->count == recorder->capacity) {
+        recorder->capacity = recorder->capacity * 2 + 1024;
+        recorder->states = realloc(
+            recorder->states, recorder->capacity * sizeof(state_t));
+    }
+    recorder->states[recorder->count++] = (state_t){{
+        hand_mask(&player->hand),
+        hand_mask(&player->opponent->hand),
+    }};
+    return play_compy_turn(player);
+}
+
+static const strategy_def_t recording_def = {
+    .name = "recording",
+    .read_rank = &recording_read_rank,
+};
+
+// relabel the suits of a mask, suit s becomes to[s]
+static card_mask_t permute(card_mask_t mask, const int to[4]) {
+    card_mask_t out = 0;
+    for (range(suit, 0, 4, 1))
+        out |= (mask >> 13 * suit & CANON_SUIT_BITS) << 13 * to[suit];
+    return out;
+}
+
+int canon_bench(long games, uint64_t seed) {
+    if (games <= 0) ohcrap("the number of games must be positive");
+
+    printf("whole spaces:\n");
+    state_t* space = malloc(1624350 * sizeof(state_t));  // the largest
+    char     label[32];
+    for (range(size, 1, 5, 1)) {
+        snprintf(label, sizeof(label), "one hand of %i", size);
+        report(label, space, every_hand(space, size, 0));
+    }
+    report("two hands of 2", space, every_hand(space, 2, 2));
+    free(space);
+
+    // the positions asked from in real games
+    recorder_t        recorder = {0};
+    strategy_t        recording = {.def = &recording_def, .ctx = &recorder};
+    const strategy_t* seats[2] = {&recording, &recording};
+    for (long game = 0; game < games; game++) sim_play(seats, seed, game);
+    endgame_release();
+
+    printf("%li games of random vs random:\n", games);
+    report("positions asked from", recorder.states, recorder.count);
+
+    // canonical forms can't depend on how the suits were labelled
+    rng_t rng;
+    rng_seed(&rng, seed);
+    long wrong = 0;
+    for (long idx = 0; idx < recorder.count; idx++) {
+        int to[4] = {0, 1, 2, 3};
+        for (range(suit, 0, 3, 1)) {
+            int pick = suit + rng_below(&rng, 4 - suit), swap = to[suit];
+            to[suit] = to[pick];
+            to[pick] = swap;
+        }
+        state_t a = recorder.states[idx], b;
+        for (range(m, 0, 2, 1)) b.masks[m] = permute(a.masks[m], to);
+        canon_masks(a.masks, 2);
+        canon_masks(b.masks, 2);
+        wrong += memcmp(&a, &b, sizeof(state_t)) != 0;
+    }
+    printf(
+        "relabelled suits of every position: %li canonical forms "
+        "differed %s\n",
+        wrong,
+        wrong == 0 ? "ok" : "WRONG");
+
+    // the cost of one call, on those positions
+    long                 calls = 0;
+    volatile card_mask_t sink = 0;  // keeps the calls from being dropped
+    double               start = sim_now(), secs;
+    do {
+        for (long idx = 0; idx < recorder.count; idx++) {
+            state_t state = recorder.states[idx];
+            canon_masks(state.masks, 2);
+            sink ^= state.masks[0] ^ state.masks[1];
+        }
+        calls += recorder.count;
+    } while ((secs = sim_now() - start) < CANON_TIMING_SECS);
+    printf(
+        "canon_masks on 2 masks: %.2f ns per call (%li calls)\n",
+        secs * 1e9 / calls,
+        calls);
+
+    free(recorder.states);
+    return wrong != 0;
+}
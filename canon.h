@@ -0,0 +1,88 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "card.h"
+
+/** === [ Suit canonicalization ] ===
+ *
+ * Nothing in the rules cares about suits, so states that only differ
+ * by swapping suits around play out the same, and a cache keyed on raw
+ * hands can hold up to 4! = 24 copies of every state. Canonicalizing
+ * before the lookup folds those copies into one.
+ *
+ * card_idx_t goes suit by suit, so in a card_mask_t each suit is its
+ * own 13 bit field. Canonicalizing a set of masks (say each player's
+ * hand, or a hand and the cards known to be in the deck; books are
+ * whole ranks so they don't change) has to apply the same relabelling
+ * of suits to all of them. So each suit's fields from every mask are
+ * packed into one word, the 4 words are sorted (a 5 comparator
+ * network), and the masks are rebuilt from the sorted words. Two sets
+ * of masks are the same up to suits exactly when their sorted words
+ * are equal, so the canonical form is the one with the suits ordered
+ * by those words, largest first.
+ *
+ * Up to 4 masks fit a word (4 * 13 bits); --canon measures how many
+ * distinct states that leaves and what it costs.
+ */
+
+#define CANON_MASKS_MAX 4
+#define CANON_SUIT_BITS 0x1fffull  // one suit of a mask
+
+/**
+ * @brief put `count` masks (at most CANON_MASKS_MAX) in the canonical
+ * suit order, in place, with the same relabelling of suits for all
+ */
+static inline void canon_masks(card_mask_t* const masks, int count) {
+    uint64_t suits[4] = {0};
+    for (range(idx, 0, count, 1))
+        for (range(suit, 0, 4, 1))
+            suits[suit] |= (masks[idx] >> 13 * suit & CANON_SUIT_BITS)
+                           << 13 * idx;
+
+    // largest first, branch free
+    static const uint8_t network[5][2] = {
+        {0, 1}, {2, 3}, {0, 2}, {1, 3}, {1, 2}};
+    for (range(step, 0, 5, 1)) {
+        uint64_t a = suits[network[step][0]], b = suits[network[step][1]];
+        suits[network[step][0]] = a > b ? a : b;
+        suits[network[step][1]] = a > b ? b : a;
+    }
+
+    for (range(idx, 0, count, 1)) {
+        card_mask_t mask = 0;
+        for (range(suit, 0, 4, 1))
+            mask |= (suits[suit] >> 13 * idx & CANON_SUIT_BITS)
+                    << 13 * suit;
+        masks[idx] = mask;
+    }
+}
+
+/**
+ * @brief count the distinct states left by canonicalizing, for whole
+ * spaces of small hands and for states out of `games` played games,
+ * and time canon_masks
+ *
+ * @return int process exit code
+ */
+int canon_bench(long games, uint64_t seed);
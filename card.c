@@ -24,110 +24,169 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <ctype.h>
+#include <time.h>
 
 #include "card.h"
+#include "check.h"
 
-rank_t rank_from_str(char* const str) {
-    if (strcmp("10", str) == 0) return RANK_10;
-    if (strlen(str) != 1) return RANK_NULL;
+_Thread_local FILE* game_out = NULL;
 
-    char c = str[0];
+#define SUIT_OF_13(s) s, s, s, s, s, s, s, s, s, s, s, s, s
+#define RANKS_2_TO_ACE                                                  \
+    RANK_2, RANK_3, RANK_4, RANK_5, RANK_6, RANK_7, RANK_8, RANK_9,      \
+        RANK_10, RANK_JACK, RANK_QUEEN, RANK_KING, RANK_ACE
+#define SLOTS_0_TO_12 0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12
 
-    // return a numbered rank
-    if (('2' <= c) && (c <= '9')) {
-        return c - '2' + RANK_2;
-    }
+const rank_t card_idx_ranks[52] = {
+    RANKS_2_TO_ACE,
+    RANKS_2_TO_ACE,
+    RANKS_2_TO_ACE,
+    RANKS_2_TO_ACE,
+};
 
-    // otherwise it must be a king, queen, jack, or ace
-    // if not, it's not a rank...
-    switch (toupper(c)) {
-        case 'J':
-            return RANK_JACK;
-        case 'Q':
-            return RANK_QUEEN;
-        case 'K':
-            return RANK_KING;
-        case 'A':
-            return RANK_ACE;
-        default:
-            return RANK_NULL;
-    }
+const suit_t card_idx_suits[52] = {
+    SUIT_OF_13(SUIT_HEARTS),
+    SUIT_OF_13(SUIT_CLUBS),
+    SUIT_OF_13(SUIT_DIAMONDS),
+    SUIT_OF_13(SUIT_SPADES),
+};
+
+const uint8_t card_idx_slots[52] = {
+    SLOTS_0_TO_12,
+    SLOTS_0_TO_12,
+    SLOTS_0_TO_12,
+    SLOTS_0_TO_12,
+};
+
+#undef SUIT_OF_13
+#undef RANKS_2_TO_ACE
+#undef SLOTS_0_TO_12
+
+// every single character rank, anything not listed is RANK_NULL
+static const rank_t _rank_parse[256] = {
+    ['2'] = RANK_2,
+    ['3'] = RANK_3,
+    ['4'] = RANK_4,
+    ['5'] = RANK_5,
+    ['6'] = RANK_6,
+    ['7'] = RANK_7,
+    ['8'] = RANK_8,
+    ['9'] = RANK_9,
+    ['J'] = RANK_JACK,
+    ['j'] = RANK_JACK,
+    ['Q'] = RANK_QUEEN,
+    ['q'] = RANK_QUEEN,
+    ['K'] = RANK_KING,
+    ['k'] = RANK_KING,
+    ['A'] = RANK_ACE,
+    ['a'] = RANK_ACE,
+};
+
+rank_t rank_from_str(char* const str) {
+    const unsigned char* s = (const unsigned char*)str;
+
+    // 10 is the only two character rank
+    if (s[0] == '1')
+        return s[1] == '0' && s[2] == '\0' ? RANK_10 : RANK_NULL;
+    if (s[0] == '\0' || s[1] != '\0') return RANK_NULL;
+    return _rank_parse[s[0]];
 }
 
 static const char* _ranks_as_strs[] =
     {"2", "3", "4", "5", "6", "7", "8", "9", "10", "J", "Q", "K", "A"};
 
-const char* rank_as_str(rank_t r) { return _ranks_as_strs[r - RANK_2]; }
+const char* rank_as_str(rank_t r) {
+    if (r < RANK_2 || r > RANK_ACE) return "?";
+    return _ranks_as_strs[r - RANK_2];
+}
+
+/**
+ * the rendered cards, built at compile time: a glyph is the card as
+ * card_sfmt has always printed it, optionally wrapped in the suit's color
+ */
+#define GLYPH(text) {sizeof(text) - 1, text}
+#define SUIT_GLYPHS(pre, suit, post)                                  \
+    GLYPH(pre "[2 " suit "]" post), GLYPH(pre "[3 " suit "]" post),   \
+        GLYPH(pre "[4 " suit "]" post), GLYPH(pre "[5 " suit "]" post), \
+        GLYPH(pre "[6 " suit "]" post), GLYPH(pre "[7 " suit "]" post), \
+        GLYPH(pre "[8 " suit "]" post), GLYPH(pre "[9 " suit "]" post), \
+        GLYPH(pre "[10" suit "]" post), GLYPH(pre "[J " suit "]" post), \
+        GLYPH(pre "[Q " suit "]" post), GLYPH(pre "[K " suit "]" post), \
+        GLYPH(pre "[A " suit "]" post)
+
+static const card_glyph_t _glyphs[2][52] = {
+    {
+        SUIT_GLYPHS("", "♥", ""),
+        SUIT_GLYPHS("", "♣", ""),
+        SUIT_GLYPHS("", "♦", ""),
+        SUIT_GLYPHS("", "♠", ""),
+    },
+    {
+        SUIT_GLYPHS(ESC_RED, "♥", ESC_RST),
+        SUIT_GLYPHS(ESC_WHT, "♣", ESC_RST),
+        SUIT_GLYPHS(ESC_RED, "♦", ESC_RST),
+        SUIT_GLYPHS(ESC_WHT, "♠", ESC_RST),
+    },
+};
+
+static const card_glyph_t _unknown_glyph = GLYPH("[? ?]");
+
+#undef SUIT_GLYPHS
+#undef GLYPH
+
+const card_glyph_t* card_glyph(card_t c, bool color) {
+    card_idx_t idx = card_idx(c);
+    if (idx == CARD_IDX_NULL) return &_unknown_glyph;
+    return &_glyphs[color][idx];
+}
 
 void card_sfmt(card_t c, card_pretty_str_t* str) {
-    char* suit = NULL;
-    switch (c.suit) {
-        case SUIT_HEARTS:
-            suit = "♥";
-            break;
-        case SUIT_CLUBS:
-            suit = "♣";
-            break;
-        case SUIT_DIAMONDS:
-            suit = "♦";
-            break;
-        case SUIT_SPADES:
-            suit = "♠";
-            break;
-        default:
-            suit = "?";
-            break;
-    }
+    const card_glyph_t* glyph = card_glyph(c, false);
+    memcpy(str->str, glyph->str, glyph->length + 1);
+}
 
-    sprintf(str->str, "[%-2s%s]", rank_as_str(c.rank), suit);
+size_t cards_render(
+    char*               dest,
+    const card_t* const cards,
+    size_t              count,
+    bool                color  //
+) {
+    char* end = dest;
+    for (range(idx, 0, (int)count, 1)) {
+        const card_glyph_t* glyph = card_glyph(cards[idx], color);
+        memcpy(end, glyph->str, glyph->length);
+        end += glyph->length;
+        *end++ = ' ';
+    }
+    *end = '\0';
+    return end - dest;
 }
 
-static inline hand_node_t new_hand_node(card_t card) {
+static inline hand_node_t new_hand_node(card_idx_t card) {
     hand_node_t node = malloc(sizeof(struct hand_node));
     *node = (struct hand_node){.card = card, .next = NULL};
     return node;
 }
 
 void hand_add_card(hand_t* hand, card_t card) {
+    hand_add_card_idx(hand, card_idx(card));
+}
+
+void hand_add_card_idx(hand_t* hand, card_idx_t card) {
     hand_node_t new_node = new_hand_node(card);  // nullable
     new_node->next = NULL;
 
     // TODO make the hand_add_card insert in rank order
 
-    if (hand->head == NULL) {
-        if (hand->length != 0)
-            ohcrap("mis-matched hand size (>0 with NULL)");
-        // else {
-        //     printf("(*0: %s) ", x.str);
-        // }
+    // append after the tail, recounting the list is left to check_hand
+    if (hand->head == NULL)
         hand->head = new_node;
-        hand->length++;
-    } else {
-        // iterate over the nodes and find the last one
-        hand_node_t last = hand->head;
-        int         card_count = 1;
-        while (last->next != NULL) {
-            last = last->next;
-            card_count++;
-        }
+    else
+        hand->tail->next = new_node;
+    hand->tail = new_node;
+    hand->length++;
 
-        // Add the node
-        last->next = new_node;
-        card_count++;
-        hand->length++;
-
-        // sanity check
-        if (card_count != hand->length) {
-            char* errstr;
-            asprintf(
-                &errstr,
-                "mis-matched hand size (count mismatch %i != %i)",
-                card_count,
-                (int)hand->length);
-            ohcrap(errstr);
-        }
-    }
+    if (check_due()) check_hand(hand);
 }
 
 void hand_search_remove_cards(
@@ -140,18 +199,20 @@ void hand_search_remove_cards(
 
     hand_node_t node = hand->head;
     // while the head contains the card, pop and write it out
-    while (hand->head != NULL && hand->head->card.rank == rank) {
+    while (hand->head != NULL && card_idx_rank(hand->head->card) == rank) {
         node = hand->head;
-        dest[pos++] = node->card;
+        dest[pos++] = card_from_idx(node->card);
 
         hand->head = node->next;
         free(node);
         hand->length--;
     }
+    // the popped head was just freed, continue from the new one
+    node = hand->head;
 
     // iterate over the rest of the nodes
     while (node != NULL && node->next != NULL) {
-        if (node->next->card.rank != rank) {
+        if (card_idx_rank(node->next->card) != rank) {
             // proceed forward
             node = node->next;
         } else {
@@ -159,41 +220,151 @@ void hand_search_remove_cards(
             hand_node_t popped = node->next;
             node->next = popped->next;
             // write out the card
-            dest[pos++] = popped->card;
+            dest[pos++] = card_from_idx(popped->card);
             // release the hand node
             free(popped);
             hand->length--;
         }
     }
+    // the loop stops on the last node, if there are any
+    hand->tail = node;
 
     *count += pos;
+    if (check_due()) check_hand(hand);
 }
 
 int hand_has_rank(const hand_t* const hand, rank_t rank) {
     hand_node_t node = hand->head;
     int         rank_count = 0;
     while (node != NULL) {
-        if (node->card.rank == rank) rank_count++;
+        if (card_idx_rank(node->card) == rank) rank_count++;
         node = node->next;
     }
     return rank_count;
 }
 
+card_mask_t hand_mask(const hand_t* const hand) {
+    card_mask_t mask = 0;
+    for (hand_node_t node = hand->head; node != NULL; node = node->next)
+        mask |= (card_mask_t)1 << node->card;
+    return mask;
+}
+
 void cards_asfmt(
     char**              new_string,
     const card_t* const cards,
     size_t              from_idx,
     size_t              upto_idx  //
+) {
+    size_t count = upto_idx - from_idx;
+    char*  str = malloc(count * CARD_RENDER_MAX + 1);
+    cards_render(str, &cards[from_idx], count, false);
+    *new_string = str;
+}
+
+/**
+ * the way cards were rendered before the glyph table, kept to measure
+ * the table against
+ */
+static void legacy_card_sfmt(card_t c, card_pretty_str_t* str) {
+    char* suit = NULL;
+    switch (c.suit) {
+        case SUIT_HEARTS:
+            suit = "♥";
+            break;
+        case SUIT_CLUBS:
+            suit = "♣";
+            break;
+        case SUIT_DIAMONDS:
+            suit = "♦";
+            break;
+        case SUIT_SPADES:
+            suit = "♠";
+            break;
+        default:
+            suit = "?";
+            break;
+    }
+
+    sprintf(str->str, "[%-2s%s]", rank_as_str(c.rank), suit);
+}
+
+static void legacy_cards_asfmt(
+    char**              new_string,
+    const card_t* const cards,
+    size_t              from_idx,
+    size_t              upto_idx  //
 ) {
     char* str = calloc((upto_idx - from_idx) + 3, sizeof(card_pretty_str_t));
 
     for (range(idx, from_idx, upto_idx, 1)) {
         card_pretty_str_t buf;
-        card_sfmt(cards[idx], &buf);
+        legacy_card_sfmt(cards[idx], &buf);
         sprintf(&str[strlen(str)], "%s ", buf.str);
     }
 
     str[strlen(str)] = '\0';
 
     *new_string = str;
-}
\ No newline at end of file
+}
+
+int cards_render_bench(int hands) {
+    if (hands <= 0) ohcrap("the number of hands must be positive");
+
+    // a pool of random 7 card hands, reused round robin
+    enum { POOL = 1024, HAND = 7 };
+    card_t*  pool = malloc(POOL * HAND * sizeof(card_t));
+    unsigned seed = time(NULL);
+    for (range(idx, 0, POOL * HAND, 1)) {
+        pool[idx].suit = SUIT_HEARTS + rand_r(&seed) % 4;
+        pool[idx].rank = RANK_2 + rand_r(&seed) % 13;
+    }
+
+    // both paths have to render every hand in the pool identically
+    char buf[HAND * CARD_RENDER_MAX + 1];
+    bool same = true;
+    for (range(idx, 0, POOL, 1)) {
+        char* str;
+        legacy_cards_asfmt(&str, &pool[idx * HAND], 0, HAND);
+        cards_render(buf, &pool[idx * HAND], HAND, false);
+        same = same && strcmp(str, buf) == 0;
+        free(str);
+    }
+
+    // checksum the output so neither loop can be optimized away
+    size_t legacy_sum = 0, table_sum = 0;
+
+    clock_t start = clock();
+    for (range(idx, 0, hands, 1)) {
+        char* str;
+        legacy_cards_asfmt(&str, &pool[(idx % POOL) * HAND], 0, HAND);
+        legacy_sum += strlen(str) + (unsigned char)str[1];
+        free(str);
+    }
+    double legacy_secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    start = clock();
+    for (range(idx, 0, hands, 1)) {
+        size_t len =
+            cards_render(buf, &pool[(idx % POOL) * HAND], HAND, false);
+        table_sum += len + (unsigned char)buf[1];
+    }
+    double table_secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+
+    printf(
+        "%i hands of %i cards\n"
+        "sprintf:     %12.0f hands/sec\n"
+        "glyph table: %12.0f hands/sec (%.1fx)\n",
+        hands,
+        HAND,
+        hands / legacy_secs,
+        hands / table_secs,
+        legacy_secs / table_secs);
+    free(pool);
+
+    if (!same || legacy_sum != table_sum) {
+        fprintf(stderr, "the two renderings differ\n");
+        return 1;
+    }
+    return 0;
+}
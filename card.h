@@ -25,6 +25,7 @@
 #include <stdbool.h>
 #include <stdint.h>
 #include <stddef.h>
+#include <stdio.h>
 
 /**
  * @brief Terminal escape color codes
@@ -39,6 +40,24 @@
 #define ESC_WHT "\e[37m"
 #define ESC_RST "\e[0m"
 
+/**
+ * @brief where the game narration is written, NULL silences it
+ *
+ * The interactive game points this at stdout; headless modes (the
+ * server, etc) leave it NULL so play_turn runs quietly. It's per
+ * thread, so threads playing turns out ahead of time (see speculate.h)
+ * stay quiet while the game itself prints.
+ */
+extern _Thread_local FILE* game_out;
+
+/**
+ * @brief printf, but to game_out (and only if there is one)
+ */
+#define game_printf(...)                                      \
+    do {                                                      \
+        if (game_out != NULL) fprintf(game_out, __VA_ARGS__); \
+    } while (0)
+
 /**
  * @brief A sugar-only macro used to enforce for loop structure
  *
@@ -109,6 +128,87 @@ typedef struct {
 
 #define CARD_NULL ((card_t){.suit = SUIT_NULL, .rank = RANK_NULL})
 
+/**
+ * @brief a card packed into one byte, 0-51
+ *
+ * Cards are numbered suit by suit in the order deck_init lays them out,
+ * index = suit * 13 + rank (both counted from 0). This is how the deck
+ * and hands store cards; card_t is what the rest of the API takes and
+ * returns, converting at the edge costs a table lookup.
+ */
+typedef uint8_t card_idx_t;
+
+#define CARD_IDX_NULL ((card_idx_t)0xFF)
+
+// what each card index is, see the card_idx_* helpers
+extern const rank_t  card_idx_ranks[52];
+extern const suit_t  card_idx_suits[52];
+extern const uint8_t card_idx_slots[52];
+
+/**
+ * @brief the index of a card, CARD_IDX_NULL if it isn't a real card
+ */
+static inline card_idx_t card_idx(card_t c) {
+    if (c.suit < SUIT_HEARTS || c.suit > SUIT_SPADES || c.rank < RANK_2 ||
+        c.rank > RANK_ACE)
+        return CARD_IDX_NULL;
+    return (c.suit - SUIT_HEARTS) * 13 + (c.rank - RANK_2);
+}
+
+/**
+ * @brief the card at an index, CARD_NULL if the index is out of range
+ */
+static inline card_t card_from_idx(card_idx_t idx) {
+    if (idx >= 52) return CARD_NULL;
+    return (card_t){
+        .suit = card_idx_suits[idx], .rank = card_idx_ranks[idx]};
+}
+
+static inline rank_t card_idx_rank(card_idx_t idx) {
+    return card_idx_ranks[idx];
+}
+
+static inline suit_t card_idx_suit(card_idx_t idx) {
+    return card_idx_suits[idx];
+}
+
+/**
+ * @brief the card's rank counted from 0 (the 2s), for indexing per rank
+ * tables without `rank - RANK_2`
+ */
+static inline uint8_t card_idx_slot(card_idx_t idx) {
+    return card_idx_slots[idx];
+}
+
+/**
+ * @brief a set of cards as a bitmask, bit i is card index i
+ *
+ * Since indexes go suit by suit, the cards of rank slot r are bits r,
+ * r + 13, r + 26 and r + 39: CARD_MASK_RANK_2 shifted left by r.
+ */
+typedef uint64_t card_mask_t;
+
+#define CARD_MASK_RANK_2 \
+    ((card_mask_t)1 | (card_mask_t)1 << 13 | (card_mask_t)1 << 26 | \
+     (card_mask_t)1 << 39)
+
+#define CARD_MASK_ALL (((card_mask_t)1 << 52) - 1)
+
+/**
+ * @brief the mask of all four cards of a rank slot
+ */
+static inline card_mask_t card_mask_rank(int slot) {
+    return CARD_MASK_RANK_2 << slot;
+}
+
+/**
+ * @brief the n-th (from 0) card in a mask, in card index order
+ */
+static inline card_idx_t card_mask_nth(card_mask_t mask, int n) {
+    for (range(_, 0, n, 1)) mask &= mask - 1;
+    return __builtin_ctzll(mask);
+}
+
 /**
  * @brief a linked list node of a hand / group of cards
  * @ownership the hand this node is a member of
@@ -120,7 +220,7 @@ typedef struct {
  *
  */
 typedef struct hand_node {
-    card_t            card;
+    card_idx_t        card;
     struct hand_node* next;  // nullable
 } * hand_node_t;
 // TODO: determine if defining a struct pointer in a typedef is poor practice
@@ -132,6 +232,7 @@ typedef struct hand_node {
  */
 typedef struct {
     hand_node_t head;  // nullable
+    hand_node_t tail;  // nullable, the last node, what cards append to
     size_t      length;
 } hand_t;
 
@@ -160,6 +261,27 @@ typedef struct {
     char str[8];  // more than needed just to be safe
 } card_pretty_str_t;
 
+/**
+ * @brief a card rendered ahead of time, see card_glyph
+ */
+typedef struct {
+    uint8_t length;   // bytes, not counting the terminator
+    char    str[23];  // the color escapes make these much longer
+} card_glyph_t;
+
+// the most bytes cards_render writes per card, including the space
+#define CARD_RENDER_MAX 24
+
+/**
+ * @brief look up how a card is rendered, e.g. `[10♥]`
+ *
+ * All 52 cards are rendered at compile time, so showing a card is a
+ * table index and a memcpy. Invalid cards render as `[? ?]`.
+ *
+ * @param color wrap the card in its suit's terminal color
+ */
+const card_glyph_t* card_glyph(card_t, bool color);
+
 /**
  * @brief print the card using unicode card suits
  *
@@ -167,6 +289,19 @@ typedef struct {
  */
 void card_sfmt(card_t, card_pretty_str_t*);
 
+/**
+ * @brief render cards, each followed by a space, into dest
+ *
+ * @param dest at least `count * CARD_RENDER_MAX + 1` bytes
+ * @param color see card_glyph
+ * @return size_t the length written, not counting the terminator
+ */
+size_t cards_render(
+    char*               dest,
+    const card_t* const cards,
+    size_t              count,
+    bool                color);
+
 /**
  * @brief check if one more chards in the given have have the desired
  * rank
@@ -175,12 +310,22 @@ void card_sfmt(card_t, card_pretty_str_t*);
  */
 int hand_has_rank(const hand_t* const hand, rank_t rank);
 
+/**
+ * @brief the cards in a hand as a mask, see card_mask_t
+ */
+card_mask_t hand_mask(const hand_t* const hand);
+
 /**
  * @brief add a new node the a hand_t with the given card value
  *
  */
 void hand_add_card(hand_t*, card_t);
 
+/**
+ * @brief hand_add_card, for a card already in index form
+ */
+void hand_add_card_idx(hand_t*, card_idx_t);
+
 /**
  * @brief searches for all the cards of the given ranks and puts them
  * into the dest pointer
@@ -213,6 +358,14 @@ void cards_asfmt(
     size_t              from_idx,
     size_t              upto_idx);
 
+/**
+ * @brief render `hands` random hands through the glyph table and the
+ * old sprintf path and report hands/sec for each
+ *
+ * @return int process exit code
+ */
+int cards_render_bench(int hands);
+
 /**
  * @brief print an error message and bail out of the program, this should
  * never need to be called
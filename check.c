@@ -0,0 +1,144 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "check.h"
+
+check_level_t          check_level = CHECK_SAMPLED;
+uint32_t               check_every = CHECK_EVERY;
+_Thread_local uint32_t check_since = 0;
+
+err_t check_configure(const char* const level) {
+    if (strcmp(level, "off") == 0) {
+        check_level = CHECK_OFF;
+    } else if (strcmp(level, "full") == 0) {
+        check_level = CHECK_FULL;
+    } else if (strcmp(level, "sampled") == 0) {
+        check_level = CHECK_SAMPLED;
+        check_every = CHECK_EVERY;
+    } else if (strncmp(level, "sampled:", 8) == 0) {
+        char* end;
+        long  every = strtol(&level[8], &end, 10);
+        if (*end != '\0' || every < 1 || every > UINT32_MAX) return ERROR;
+        check_level = CHECK_SAMPLED;
+        check_every = every;
+    } else {
+        return ERROR;
+    }
+
+    if (check_level > CHECK_BUILD_LEVEL) {
+        fprintf(
+            stderr,
+            "this build checks at most %s\n",
+            CHECK_BUILD_LEVEL == CHECK_OFF ? "never" : "sampled");
+        check_level = CHECK_BUILD_LEVEL;
+    }
+    return SUCCESS;
+}
+
+void check_hand(const hand_t* const hand) {
+    if (hand->head == NULL) {
+        if (hand->length != 0 || hand->tail != NULL)
+            ohcrap("mis-matched hand size (>0 with NULL)");
+        return;
+    }
+
+    card_mask_t seen = 0;
+    size_t      count = 0;
+    hand_node_t last = NULL;
+    for (hand_node_t node = hand->head; node != NULL; node = node->next) {
+        if (node->card >= 52) ohcrap("a hand holds a card that isn't one");
+        if (seen & (card_mask_t)1 << node->card)
+            ohcrap("a hand has a card in it twice");
+        seen |= (card_mask_t)1 << node->card;
+        last = node;
+        // a loop would never end, a longer list can't be a hand
+        if (++count > 52) ohcrap("a hand's list loops");
+    }
+
+    if (count != hand->length) {
+        char* errstr;
+        asprintf(
+            &errstr,
+            "mis-matched hand size (count mismatch %zu != %zu)",
+            count,
+            hand->length);
+        ohcrap(errstr);
+    }
+    if (last != hand->tail) ohcrap("a hand's tail isn't its last card");
+}
+
+void check_books(const player_t* const player) {
+    bool     prev_was_blank = false;
+    uint16_t slots = 0;
+    for (range(idx, 0, RULES_TO_WIN, 1)) {
+        // once the books are terminated the rest should be RANK_NULLs
+        rank_t book = player->books[idx];
+        if (prev_was_blank && book != RANK_NULL)
+            ohcrap("invalid book, incorrectly terminated");
+        prev_was_blank = book == RANK_NULL;
+        if (book == RANK_NULL) continue;
+        if (book < RANK_2 || book > RANK_ACE)
+            ohcrap("a book of a rank that isn't one");
+        if (slots & 1 << (book - RANK_2)) ohcrap("a rank booked twice");
+        slots |= 1 << (book - RANK_2);
+    }
+}
+
+void check_table(
+    const player_t* const a,
+    const player_t* const b,
+    const deck_t* const   deck  //
+) {
+    check_books(a);
+    check_books(b);
+    check_hand(&a->hand);
+    check_hand(&b->hand);
+
+    uint16_t a_booked = player_booked_slots(a);
+    uint16_t b_booked = player_booked_slots(b);
+    if (a_booked & b_booked) ohcrap("a rank booked by both players");
+    card_mask_t books = 0;
+    for (range(slot, 0, 13, 1))
+        if ((a_booked | b_booked) >> slot & 1) books |= card_mask_rank(slot);
+
+    if (deck->remaining > 52) ohcrap("the deck has more than 52 cards");
+    card_mask_t in_deck = 0;
+    for (range(idx, 0, deck->remaining, 1)) {
+        if (deck->cards[idx] >= 52) ohcrap("a card in the deck isn't one");
+        card_mask_t card = (card_mask_t)1 << deck->cards[idx];
+        if (in_deck & card) ohcrap("the deck has a card in it twice");
+        in_deck |= card;
+    }
+
+    card_mask_t a_hand = hand_mask(&a->hand), b_hand = hand_mask(&b->hand);
+    if ((a_hand | b_hand) & books)
+        ohcrap("a booked rank is still in a hand");
+    if ((a_hand & b_hand) || ((a_hand | b_hand | books) & in_deck))
+        ohcrap("a card is in two places at once");
+    if ((a_hand | b_hand | books | in_deck) != CARD_MASK_ALL)
+        ohcrap("cards have gone missing from the table");
+}
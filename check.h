@@ -0,0 +1,102 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "player.h"
+
+/** === [ Invariant checks ] ===
+ *
+ * Walking a hand to recount it, or every card on the table to see none
+ * went missing, costs more than the operation being checked, so the
+ * checks run at one of three levels:
+ *
+ *   off          never
+ *   sampled[:N]  one check in N (per thread), the default, 1 in
+ *                CHECK_EVERY
+ *   full         every time
+ *
+ * chosen at run time with `gofish --check <level> ...` in front of any
+ * other arguments. At build time -DCHECK_BUILD_LEVEL=CHECK_OFF (or
+ * CHECK_SAMPLED) caps the level, and with it off every check compiles
+ * away, for release simulation builds.
+ *
+ * A failed check exits through ohcrap saying what broke.
+ */
+
+typedef enum {
+    CHECK_OFF,
+    CHECK_SAMPLED,
+    CHECK_FULL,
+} check_level_t;
+
+#ifndef CHECK_BUILD_LEVEL
+#define CHECK_BUILD_LEVEL CHECK_FULL
+#endif
+
+#define CHECK_EVERY 1024  // the default sampling period
+
+extern check_level_t          check_level;
+extern uint32_t               check_every;
+extern _Thread_local uint32_t check_since;  // checks skipped in a row
+
+/**
+ * @brief whether the check at hand should run
+ */
+static inline bool check_due() {
+    if (CHECK_BUILD_LEVEL == CHECK_OFF || check_level == CHECK_OFF)
+        return false;
+    if (check_level == CHECK_FULL) return true;
+    if (++check_since < check_every) return false;
+    check_since = 0;
+    return true;
+}
+
+/**
+ * @brief set the level from `off`, `sampled`, `sampled:<N>` or `full`,
+ * capped at the build's level
+ *
+ * @return err_t ERROR if it's none of those
+ */
+err_t check_configure(const char* const level);
+
+/**
+ * @brief the list's length matches its nodes, the tail is its last
+ * node, and no card is in it twice
+ */
+void check_hand(const hand_t* const hand);
+
+/**
+ * @brief the books are RANK_NULL terminated and no rank is in them
+ * twice
+ */
+void check_books(const player_t* const player);
+
+/**
+ * @brief all 52 cards are accounted for exactly once between the deck,
+ * the hands and the books, so in particular no booked rank is still in
+ * a hand and no rank is booked by both players
+ */
+void check_table(
+    const player_t* const a,
+    const player_t* const b,
+    const deck_t* const   deck);
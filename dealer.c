@@ -0,0 +1,170 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sched.h>
+#include <time.h>
+
+#include "dealer.h"
+
+#define SLOT_MASK (DEALER_SLOTS - 1)
+
+static void* produce(void* arg) {
+    dealer_t* dealer = arg;
+    deck_t    decks[DEALER_BATCH];
+
+    for (uint64_t base = 0; base < dealer->games; base += DEALER_BATCH) {
+        int count = DEALER_BATCH;
+        if (dealer->games - base < DEALER_BATCH)
+            count = dealer->games - base;
+
+        sim_deal(decks, dealer->seed, base, count);
+
+        for (range(idx, 0, count, 1)) {
+            uint64_t       pos = base + idx;
+            dealer_slot_t* slot = &dealer->slots[pos & SLOT_MASK];
+
+            // wait for the workers to empty the slot
+            while (atomic_load_explicit(&slot->seq, memory_order_acquire) !=
+                   pos) {
+                if (atomic_load(&dealer->stop)) return NULL;
+                sched_yield();
+            }
+
+            slot->deal = (deal_t){.game = pos, .deck = decks[idx]};
+            atomic_store_explicit(
+                &slot->seq, pos + 1, memory_order_release);
+        }
+    }
+    return NULL;
+}
+
+dealer_t* dealer_start(uint64_t seed, uint64_t games) {
+    dealer_t* dealer = malloc(sizeof(dealer_t));
+    if (dealer == NULL) ohcrap("could not allocate a dealer");
+
+    dealer->seed = seed;
+    dealer->games = games;
+    atomic_init(&dealer->stop, false);
+    atomic_init(&dealer->head, 0);
+    for (range(idx, 0, DEALER_SLOTS, 1))
+        atomic_init(&dealer->slots[idx].seq, idx);
+
+    if (pthread_create(&dealer->thread, NULL, &produce, dealer) != 0)
+        ohcrap("could not start the dealer thread");
+    return dealer;
+}
+
+err_t dealer_pop(dealer_t* const dealer, deal_t* const into) {
+    uint64_t pos = atomic_load_explicit(&dealer->head, memory_order_relaxed);
+    for (;;) {
+        if (pos >= dealer->games || atomic_load(&dealer->stop)) return ERROR;
+
+        dealer_slot_t* slot = &dealer->slots[pos & SLOT_MASK];
+        uint64_t       seq =
+            atomic_load_explicit(&slot->seq, memory_order_acquire);
+
+        if (seq == pos + 1) {
+            // it's ready, claim it (on failure pos is the new head)
+            if (atomic_compare_exchange_weak_explicit(
+                    &dealer->head,
+                    &pos,
+                    pos + 1,
+                    memory_order_relaxed,
+                    memory_order_relaxed)) {
+                *into = slot->deal;
+                // free the slot for the deal DEALER_SLOTS later
+                atomic_store_explicit(
+                    &slot->seq, pos + DEALER_SLOTS, memory_order_release);
+                return SUCCESS;
+            }
+        } else if (seq < pos + 1) {
+            // not dealt yet, let the dealer run
+            sched_yield();
+            pos = atomic_load_explicit(&dealer->head, memory_order_relaxed);
+        } else {
+            // another worker took it
+            pos = atomic_load_explicit(&dealer->head, memory_order_relaxed);
+        }
+    }
+}
+
+void dealer_stop(dealer_t* const dealer) {
+    atomic_store(&dealer->stop, true);
+}
+
+void dealer_close(dealer_t* const dealer) {
+    dealer_stop(dealer);
+    pthread_join(dealer->thread, NULL);
+    free(dealer);
+}
+
+int dealer_bench(long decks, uint64_t seed) {
+    if (decks <= 0) ohcrap("the number of decks must be positive");
+
+    // inline, the way sim_play deals: one deck right before each game
+    uint64_t inline_sum = 0;
+    double   start = sim_now();
+    for (long game = 0; game < decks; game++) {
+        deck_t deck;
+        sim_deal(&deck, seed, game, 1);
+        inline_sum += deck.cards[game % 52] * (uint64_t)game;
+    }
+    double inline_secs = sim_now() - start;
+
+    // from the dealer, checking each deck against an inline deal
+    uint64_t  dealer_sum = 0;
+    long      mismatched = 0;
+    dealer_t* dealer = dealer_start(seed, decks);
+    deal_t    deal;
+    start = sim_now();
+    while (dealer_pop(dealer, &deal))
+        dealer_sum += deal.deck.cards[deal.game % 52] * deal.game;
+    double dealer_secs = sim_now() - start;
+    dealer_close(dealer);
+
+    // then deck for deck, a deal is the same no matter where it's made
+    dealer = dealer_start(seed, decks);
+    while (dealer_pop(dealer, &deal)) {
+        deck_t deck;
+        sim_deal(&deck, seed, deal.game, 1);
+        mismatched += memcmp(&deck, &deal.deck, sizeof(deck_t)) != 0;
+    }
+    dealer_close(dealer);
+
+    printf(
+        "%li decks\n"
+        "inline: %12.0f decks/sec\n"
+        "dealer: %12.0f decks/sec popped (%.1fx)\n",
+        decks,
+        decks / inline_secs,
+        decks / dealer_secs,
+        inline_secs / dealer_secs);
+
+    if (mismatched != 0 || inline_sum != dealer_sum) {
+        fprintf(stderr, "the dealer's decks differ from inline deals\n");
+        return 1;
+    }
+    return 0;
+}
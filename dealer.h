@@ -0,0 +1,103 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "sim.h"
+
+/** === [ Dealer ] ===
+ *
+ * Shuffles the decks for a batch run on a thread of its own, ahead of
+ * the games, so the workers playing them just pop a ready deck.
+ *
+ * Game i of a run always plays the deck sim_deal gives for it (keyed by
+ * the run's seed and i). Decks are made in order and each carries its
+ * game number, so which worker pops which deck (and how many workers
+ * there are) never changes what game i is; a run with a fixed seed is
+ * reproducible on any number of threads.
+ *
+ * The queue is a bounded ring with a sequence number per slot: the one
+ * producer fills slots in order and any number of workers claim them
+ * with a compare and swap on the head, no locks either side.
+ */
+
+#define DEALER_SLOTS 1024  // decks queued ahead, a power of 2
+#define DEALER_BATCH 64    // decks shuffled together, see sim_deal
+
+/**
+ * @brief one game's deal
+ */
+typedef struct {
+    uint64_t game;  // the game's number in the run
+    deck_t   deck;
+} deal_t;
+
+typedef struct {
+    // == the slot's position when it is free for that position, that
+    // position + 1 once it holds that position's deal
+    _Atomic uint64_t seq;
+    deal_t           deal;
+} dealer_slot_t;
+
+typedef struct {
+    uint64_t         seed;
+    uint64_t         games;
+    pthread_t        thread;
+    _Atomic bool     stop;
+    _Atomic uint64_t head;  // the next deal to hand out
+    dealer_slot_t    slots[DEALER_SLOTS];
+} dealer_t;
+
+/**
+ * @brief start dealing games 0 .. games-1 of the run with this seed
+ */
+dealer_t* dealer_start(uint64_t seed, uint64_t games);
+
+/**
+ * @brief take the next deal, waiting for it if need be
+ *
+ * @return err_t ERROR once every game has been handed out or the dealer
+ * was stopped
+ */
+err_t dealer_pop(dealer_t* const dealer, deal_t* const into);
+
+/**
+ * @brief stop handing out deals, workers' dealer_pop will return ERROR
+ */
+void dealer_stop(dealer_t* const dealer);
+
+/**
+ * @brief stop the dealer and release it, call once no worker is going
+ * to pop from it again
+ */
+void dealer_close(dealer_t* const dealer);
+
+/**
+ * @brief time dealing `decks` decks one at a time inline against
+ * popping them from a dealer, and check the two give the same decks
+ *
+ * @return int process exit code
+ */
+int dealer_bench(long decks, uint64_t seed);
@@ -27,38 +27,59 @@
 #include "deck.h"
 
 void deck_init(deck_t* const d) {
-    for (range(i, 0, 52, 1)) {
-        d->cards[i] = (card_t){
-            .suit = (i / 13) + SUIT_HEARTS, .rank = (i % 13) + RANK_2};
-    };
-    d->_canary = (card_t){0, 0};
+    for (range(i, 0, 52, 1)) d->cards[i] = i;
+    d->_canary = CARD_IDX_NULL;
     d->remaining = 52;
 }
 
 void deck_shuffle(deck_t* const deck) {
-    // iterate from the top card of the deck (remaining-1) to the
-    // bottom(0) and swap it with a random card below it.
+    // seeded once, re-seeding every shuffle repeats decks within a second
+    static rng_t rng;
+    static bool  seeded = false;
+    if (!seeded) rng_seed(&rng, time(NULL));
+    seeded = true;
 
-    srand(time(NULL));
-    // NOTE: this uses rand() with mod operator (%) which is know to
-    // be a poor source of randomness when combined with  but we
-    // aren't performing anything near what needs to be secure so...
-    // ah well
+    deck_shuffle_with(deck, &rng);
+}
 
-    card_t* cards = deck->cards;
-    int     rand_pos;
+void deck_shuffle_with(deck_t* const deck, rng_t* const rng) {
+    // iterate from the top card of the deck (remaining-1) to the
+    // bottom(0) and swap it with a random card at or below it.
+    // (including itself, leaving it out can never produce a deck where
+    // a card stays put, so not every order was possible)
+    card_idx_t* cards = deck->cards;
     for (int src_pos = deck->remaining - 1; src_pos > 0; src_pos--) {
-        rand_pos = rand() % src_pos;
+        int rand_pos = rng_below(rng, src_pos + 1);
         // swap the cards
-        card_t src_card = cards[src_pos];
+        card_idx_t src_card = cards[src_pos];
         cards[src_pos] = cards[rand_pos];
         cards[rand_pos] = src_card;
     }
 }
 
+void deck_shuffle_many(deck_t* const decks, rng_t* const rngs, int count) {
+    if (count <= 0) return;
+    for (int src_pos = decks[0].remaining - 1; src_pos > 0; src_pos--) {
+        for (range(idx, 0, count, 1)) {
+            card_idx_t* cards = decks[idx].cards;
+            int         rand_pos = rng_below(&rngs[idx], src_pos + 1);
+            card_idx_t  src_card = cards[src_pos];
+            cards[src_pos] = cards[rand_pos];
+            cards[rand_pos] = src_card;
+        }
+    }
+}
+
 err_t deck_deal(deck_t* const deck, card_t* const into) {
     *into = CARD_NULL;
     if (deck->remaining == 0) return ERROR;
+    *into = card_from_idx(deck->cards[--deck->remaining]);
+    return SUCCESS;
+}
+
+err_t deck_deal_idx(deck_t* const deck, card_idx_t* const into) {
+    *into = CARD_IDX_NULL;
+    if (deck->remaining == 0) return ERROR;
     *into = deck->cards[--deck->remaining];
     return SUCCESS;
 }
@@ -25,6 +25,7 @@
 #include "stddef.h"
 
 #include "card.h"
+#include "rng.h"
 
 /**
  * @brief represents a deck and it's contents
@@ -42,9 +43,9 @@
  * not withing the number of remaining cards.
  */
 typedef struct {
-    size_t remaining;
-    card_t cards[52];
-    card_t _canary;  // overflow / canary padding
+    uint8_t    remaining;
+    card_idx_t cards[52];
+    card_idx_t _canary;  // overflow / canary padding
 } deck_t;
 
 /**
@@ -65,12 +66,34 @@ void deck_init(deck_t* const);
  */
 err_t deck_deal(deck_t* const deck, card_t* const into);
 
+/**
+ * @brief deck_deal, but as a card index (CARD_IDX_NULL if the deck is
+ * empty)
+ */
+err_t deck_deal_idx(deck_t* const deck, card_idx_t* const into);
+
 /**
  * @brief shuffle the remaining cards in the deck
  *
  */
 void deck_shuffle(deck_t* const);
 
+/**
+ * @brief shuffle the remaining cards in the deck with the given
+ * generator, the same generator state always gives the same deck
+ */
+void deck_shuffle_with(deck_t* const, rng_t* const);
+
+/**
+ * @brief shuffle `count` decks, deck i with generator i
+ *
+ * Gives exactly what deck_shuffle_with would for each pair, but steps
+ * all the decks together one position at a time so the independent
+ * generators overlap instead of each waiting on its own last draw. The
+ * decks must all have the same number of cards remaining.
+ */
+void deck_shuffle_many(deck_t* const decks, rng_t* const rngs, int count);
+
 /**
  * @brief returns the number of cards remaining in the deck (always
  * 0-52)
@@ -0,0 +1,331 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "endgame.h"
+#include "gofish.h"
+
+#define BOOKS_TO_WIN RULES_TO_WIN
+#define MOVER_SHIFT  39
+#define OTHER_SHIFT  42
+
+typedef struct {
+    uint64_t tag;  // key | ENTRY_USED, 0 for an empty slot
+    int8_t   margin;
+    uint8_t  best;  // rank index, 0xff to pass
+} entry_t;
+
+#define ENTRY_USED (1ull << 63)
+#define NO_RANK    0xff
+
+// one table per thread, so solving never takes a lock
+static _Thread_local entry_t* table = NULL;
+static _Thread_local uint64_t lookups = 0, hits = 0;
+
+static inline int rank_code(endgame_key_t key, int r) {
+    return (key >> (3 * r)) & 7;
+}
+
+static inline int mover_books(endgame_key_t key) {
+    return (key >> MOVER_SHIFT) & 7;
+}
+
+static inline int other_books(endgame_key_t key) {
+    return (key >> OTHER_SHIFT) & 7;
+}
+
+endgame_key_t endgame_key(
+    const uint8_t held[13],
+    const bool    booked[13],
+    int           mover,
+    int           other  //
+) {
+    endgame_key_t key = 0;
+    for (range(r, 0, 13, 1))
+        key |= (uint64_t)(booked[r] ? ENDGAME_BOOKED : held[r]) << (3 * r);
+    return key | (uint64_t)mover << MOVER_SHIFT |
+           (uint64_t)other << OTHER_SHIFT;
+}
+
+endgame_key_t endgame_key_for(const player_t* const mover) {
+    uint8_t held[13] = {0};
+    bool    booked[13] = {0};
+    int     books = 0, their_books = 0;
+
+    for (hand_node_t node = mover->hand.head; node != NULL;
+         node = node->next)
+        held[card_idx_slot(node->card)]++;
+
+    for (range(idx, 0, RULES_TO_WIN, 1)) {
+        if (mover->books[idx] != RANK_NULL) {
+            booked[mover->books[idx] - RANK_2] = true;
+            books++;
+        }
+        if (mover->opponent != NULL &&
+            mover->opponent->books[idx] != RANK_NULL) {
+            booked[mover->opponent->books[idx] - RANK_2] = true;
+            their_books++;
+        }
+    }
+
+    return endgame_key(held, booked, books, their_books);
+}
+
+// the same position from the other player's side of the table
+static endgame_key_t flip(endgame_key_t key) {
+    endgame_key_t flipped = 0;
+    for (range(r, 0, 13, 1)) {
+        int code = rank_code(key, r);
+        flipped |= (uint64_t)(code == ENDGAME_BOOKED ? code : 4 - code)
+                   << (3 * r);
+    }
+    return flipped | (uint64_t)other_books(key) << MOVER_SHIFT |
+           (uint64_t)mover_books(key) << OTHER_SHIFT;
+}
+
+static inline entry_t* slot_for(endgame_key_t key) {
+    if (table == NULL)
+        table = calloc((size_t)1 << ENDGAME_TABLE_BITS, sizeof(entry_t));
+    // fibonacci hashing spreads the packed fields over the index bits
+    uint64_t hash = key * 0x9e3779b97f4a7c15ull;
+    return &table[hash >> (64 - ENDGAME_TABLE_BITS)];
+}
+
+static int8_t solve(endgame_key_t key, uint8_t* const best_out) {
+    lookups++;
+    entry_t* slot = slot_for(key);
+    if (slot->tag == (key | ENTRY_USED)) {
+        hits++;
+        *best_out = slot->best;
+        return slot->margin;
+    }
+
+    int     books = mover_books(key), their_books = other_books(key);
+    int8_t  best = INT8_MIN;
+    uint8_t best_rank = NO_RANK;
+
+    // asking for a held rank always books it: every card of it that
+    // isn't in the mover's hand is in the opponent's, and a book is an
+    // extra turn
+    for (range(r, 0, 13, 1)) {
+        int code = rank_code(key, r);
+        if (code == 0 || code == ENDGAME_BOOKED) continue;
+
+        int8_t value;
+        if (books + 1 == BOOKS_TO_WIN) {
+            value = BOOKS_TO_WIN - their_books;
+        } else {
+            endgame_key_t child = key;
+            child &= ~((uint64_t)7 << (3 * r));
+            child |= (uint64_t)ENDGAME_BOOKED << (3 * r);
+            child += (uint64_t)1 << MOVER_SHIFT;
+            uint8_t ignored;
+            value = solve(child, &ignored);
+        }
+
+        if (value > best) {
+            best = value;
+            best_rank = r;
+        }
+        // winning with every book the opponent doesn't already have
+        // can't be beaten, so there's no need to look any further
+        if (best == BOOKS_TO_WIN - their_books) break;
+    }
+
+    // an empty hand with an empty deck passes the turn
+    if (best_rank == NO_RANK) {
+        endgame_key_t flipped = flip(key);
+        bool          other_can_move = false;
+        for (range(r, 0, 13, 1)) {
+            int code = rank_code(flipped, r);
+            other_can_move |= code != 0 && code != ENDGAME_BOOKED;
+        }
+
+        uint8_t ignored;
+        best = other_can_move ? -solve(flipped, &ignored)
+                              : books - their_books;  // nothing left
+    }
+
+    *slot = (entry_t){
+        .tag = key | ENTRY_USED, .margin = best, .best = best_rank};
+    *best_out = best_rank;
+    return best;
+}
+
+endgame_result_t endgame_solve(endgame_key_t key) {
+    uint8_t best;
+    int8_t  margin = solve(key, &best);
+    return (endgame_result_t){
+        .margin = margin,
+        .best = best == NO_RANK ? RANK_NULL : best + RANK_2};
+}
+
+void endgame_release() {
+    free(table);
+    table = NULL;
+}
+
+/**
+ * a random endgame: each rank booked or split between the hands, and
+ * the booked ones split so neither side has won yet
+ *
+ * @param order the booked ranks come first, the mover's `mover` of them
+ * then the opponent's
+ * @return int how many ranks are booked
+ */
+static int random_position(
+    unsigned* const seed,
+    uint8_t         held[13],
+    bool            booked[13],
+    int             order[13],
+    int* const      mover  //
+) {
+    for (range(r, 0, 13, 1)) order[r] = r;
+    for (range(r, 12, 0, -1)) {
+        int other = rand_r(seed) % (r + 1);
+        int temp = order[r];
+        order[r] = order[other];
+        order[other] = temp;
+    }
+    int count = rand_r(seed) % 13;
+    for (range(r, 0, 13, 1)) booked[r] = false;
+    for (range(idx, 0, count, 1)) booked[order[idx]] = true;
+
+    int low = count > 6 ? count - 6 : 0;
+    int high = count < 6 ? count : 6;
+    *mover = low + rand_r(seed) % (high - low + 1);
+
+    for (range(r, 0, 13, 1)) held[r] = rand_r(seed) % 5;
+    return count;
+}
+
+// both sides of a played out endgame ask what the solver says
+static rank_t solved_read_rank(player_t* player) {
+    return endgame_solve(endgame_key_for(player)).best;
+}
+
+static int books_of(const player_t* const player) {
+    int count = 0;
+    while (count < RULES_TO_WIN && player->books[count] != RANK_NULL)
+        count++;
+    return count;
+}
+
+/**
+ * play a position out through play_turn, both sides following the
+ * solver, and whether the mover's final margin is the one it solved to
+ */
+static bool plays_out(
+    const uint8_t held[13],
+    const bool    booked[13],
+    const int     order[13],
+    int           mover,
+    int           count,
+    int8_t        margin  //
+) {
+    deck_t   deck = {0};  // empty, it's the endgame
+    player_t a = player_init("Mover", false, &solved_read_rank);
+    player_t b = player_init("Other", false, &solved_read_rank);
+    player_seat(&a, &b, &deck);
+
+    for (range(idx, 0, count, 1))
+        (idx < mover ? &a : &b)->books[idx < mover ? idx : idx - mover] =
+            order[idx] + RANK_2;
+    for (range(r, 0, 13, 1)) {
+        if (booked[r]) continue;
+        for (range(suit, 0, 4, 1))
+            hand_add_card_idx(
+                suit < held[r] ? &a.hand : &b.hand, suit * 13 + r);
+    }
+
+    // every turn books a rank or passes from an empty hand, so 13 books
+    // and as many passes is more than any endgame takes
+    player_t*     playing = &a;
+    turn_result_t result = TURN_NEXT;
+    for (range(_, 0, 26, 1)) {
+        player_t* other = playing == &a ? &b : &a;
+        result = play_turn(playing, other, &deck, &a, &b);
+        if (result == TURN_WON) break;
+        if (result == TURN_NEXT) playing = other;
+    }
+
+    bool same = result == TURN_WON && books_of(&a) - books_of(&b) == margin;
+    player_cleanup(&a);
+    player_cleanup(&b);
+    return same;
+}
+
+int endgame_bench(int positions) {
+    if (positions <= 0)
+        ohcrap("the number of positions must be positive");
+
+    unsigned first_seed = time(NULL), seed = first_seed;
+    int      wins = 0;
+    clock_t  start = clock();
+
+    for (range(_, 0, positions, 1)) {
+        uint8_t held[13];
+        bool    booked[13];
+        int     order[13], mover;
+        int     count = random_position(&seed, held, booked, order, &mover);
+
+        endgame_key_t key =
+            endgame_key(held, booked, mover, count - mover);
+        wins += endgame_solve(key).margin > 0;
+    }
+
+    double secs = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf(
+        "%i endgames, the mover wins %.1f%%\n"
+        "%.0f endgames/sec, %.1f%% of %llu lookups were memo hits\n",
+        positions,
+        100.0 * wins / positions,
+        secs > 0 ? positions / secs : 0.0,
+        lookups ? 100.0 * hits / lookups : 0.0,
+        (unsigned long long)lookups);
+
+    // the same positions again, each played out by play_turn with both
+    // sides asking what the solver says, has to end on the margin it
+    // solved to or the solver's rules aren't the game's
+    seed = first_seed;
+    int differ = 0;
+    for (range(_, 0, positions, 1)) {
+        uint8_t held[13];
+        bool    booked[13];
+        int     order[13], mover;
+        int     count = random_position(&seed, held, booked, order, &mover);
+
+        endgame_key_t key =
+            endgame_key(held, booked, mover, count - mover);
+        int8_t margin = endgame_solve(key).margin;
+        differ += !plays_out(held, booked, order, mover, count, margin);
+    }
+    printf(
+        "played out through play_turn: %i of %i differ %s\n",
+        differ,
+        positions,
+        differ == 0 ? "ok" : "DIFFERENT");
+    return differ != 0;
+}
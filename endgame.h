@@ -0,0 +1,102 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "player.h"
+
+/** === [ Endgame ] ===
+ *
+ * Once the deck is empty every card that isn't booked is in one of the
+ * two hands, so each player can work out the other's hand exactly and
+ * the rest of the game is perfect information. A position is then just,
+ * per rank, how many of its cards the player to move holds (the
+ * opponent has the rest) or that it's booked, plus each side's number of
+ * books. That packs into one 64 bit key:
+ *
+ *   bits 0..38   3 bits per rank (2s first): 0-4 cards held by the
+ *                mover, ENDGAME_BOOKED if the rank is booked
+ *   bits 39..41  the mover's books
+ *   bits 42..44  the opponent's books
+ *
+ * Keys are always from the point of view of the player to move, so the
+ * side to move needs no bits of its own.
+ */
+
+#define ENDGAME_BOOKED     5
+#define ENDGAME_TABLE_BITS 16  // memo entries per thread, as a power of 2
+
+typedef uint64_t endgame_key_t;
+
+/**
+ * @brief the exact value of an endgame position under perfect play
+ */
+typedef struct {
+    // the mover's final books minus the opponent's, > 0 is a win
+    int8_t margin;
+    // a rank that achieves it, RANK_NULL if the mover has to pass
+    rank_t best;
+} endgame_result_t;
+
+/**
+ * @brief pack a position
+ *
+ * @param held cards of each rank (index 0 is the 2s) the mover holds,
+ * ignored for booked ranks
+ * @param booked whether each rank has been booked, by either player
+ */
+endgame_key_t endgame_key(
+    const uint8_t held[13],
+    const bool    booked[13],
+    int           mover_books,
+    int           other_books);
+
+/**
+ * @brief the position as seen by a seated player whose turn it is, only
+ * meaningful once the deck is empty
+ */
+endgame_key_t endgame_key_for(const player_t* const mover);
+
+/**
+ * @brief solve a position exactly
+ *
+ * Results are memoized in a fixed size table (one per thread, entries
+ * are overwritten on collision) so repeated and overlapping endgames
+ * are cheap without memory growing over a long run.
+ */
+endgame_result_t endgame_solve(endgame_key_t key);
+
+/**
+ * @brief free the calling thread's memo table, for threads that solved
+ * endgames and are about to exit
+ */
+void endgame_release();
+
+/**
+ * @brief solve `positions` random endgames and report how fast, then
+ * play each out through play_turn with both sides following the solver
+ * to check it ends on the margin solved for
+ *
+ * @return int process exit code, 1 if any position played out
+ * differently
+ */
+int endgame_bench(int positions);
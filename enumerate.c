@@ -0,0 +1,560 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "enumerate.h"
+#include "sim.h"
+#include "variant.h"
+
+/**
+ * @brief a position of a reduced game, copied (on the stack) for each
+ * move rather than undone
+ */
+typedef struct {
+    uint8_t held[2][ENUMERATE_MAX_RANKS];  // per seat, per rank
+    uint8_t deck[ENUMERATE_MAX_RANKS];     // per rank
+    uint8_t booked[ENUMERATE_MAX_RANKS];   // 0, or 1 + the seat
+    uint8_t books[2];
+    uint8_t in_hand[2];
+    uint8_t in_deck;
+} pos_t;
+
+// filled in once: tag 0 -> ENUMERATE_FILLING -> key + 1, with the
+// value stored before the tag that says it's there
+typedef struct {
+    _Atomic uint64_t tag;
+    double           value;
+} entry_t;
+
+#define ENUMERATE_FILLING UINT64_MAX
+
+typedef struct {
+    int             ranks, to_win;
+    lockstep_kind_t seats[2];
+    bool            symmetric;  // ranks are interchangeable
+    entry_t*        memo;      // shared by the threads, NULL to sample
+    int             memo_bits;
+    rng_t*          rng;       // picks one outcome per chance node
+    uint64_t        expanded;  // positions solved (not found in memo)
+    uint64_t        hits;
+} search_t;
+
+// a possible first hand, and the chance of it
+typedef struct {
+    uint8_t held[ENUMERATE_MAX_RANKS];
+    double  chance;
+} first_hand_t;
+
+typedef struct {
+    const search_t* rules;
+    int             hand;
+    first_hand_t*   hands;
+    double*         values;  // by first hand
+    long            count;
+    _Atomic long    next;
+    _Atomic long    expanded, hits;
+} job_t;
+
+// ways to pick k cards of a rank with n of it left
+static const double choose[5][5] = {
+    {1},
+    {1, 1},
+    {1, 2, 1},
+    {1, 3, 3, 1},
+    {1, 4, 6, 4, 1},
+};
+
+static double choose_big(int n, int k) {
+    double ways = 1;
+    for (range(idx, 0, k, 1)) ways = ways * (n - idx) / (idx + 1);
+    return ways;
+}
+
+/**
+ * @brief 4 bits per rank (which of the 15 ways the two hands can split
+ * its cards, or booked), each seat's books and the seat to move, the
+ * deck has the rest. Who booked which rank doesn't matter from here on,
+ * and when neither player favours any rank neither does their order,
+ * so they're sorted and every relabelling of the ranks shares a key.
+ */
+static uint64_t pos_key(const search_t* s, const pos_t* p, int mover) {
+    uint8_t codes[ENUMERATE_MAX_RANKS];
+    for (range(r, 0, s->ranks, 1)) {
+        int mine = p->held[0][r];
+        codes[r] = p->booked[r] ? 15
+                                : mine * 5 - mine * (mine - 1) / 2 +
+                                      p->held[1][r];
+    }
+    if (s->symmetric) {
+        for (range(r, 1, s->ranks, 1))
+            for (int at = r; at > 0 && codes[at - 1] < codes[at]; at--) {
+                uint8_t swap = codes[at];
+                codes[at] = codes[at - 1];
+                codes[at - 1] = swap;
+            }
+    }
+
+    uint64_t key = 0;
+    for (range(r, 0, s->ranks, 1)) key = key << 4 | codes[r];
+    return key << 7 | p->books[1] << 4 | p->books[0] << 1 | mover;
+}
+
+static bool memo_find(const search_t* s, uint64_t key, double* value) {
+    uint64_t mask = ((uint64_t)1 << s->memo_bits) - 1;
+    uint64_t at = key * 0x9e3779b97f4a7c15ull >> (64 - s->memo_bits);
+    for (range(probe, 0, ENUMERATE_PROBES, 1)) {
+        entry_t* entry = &s->memo[(at + probe) & mask];
+        uint64_t tag =
+            atomic_load_explicit(&entry->tag, memory_order_acquire);
+        if (tag == 0) return false;
+        if (tag == key + 1) {
+            *value = entry->value;
+            return true;
+        }
+    }
+    return false;
+}
+
+// nothing is ever overwritten, a full run of slots just isn't kept
+static void memo_keep(const search_t* s, uint64_t key, double value) {
+    uint64_t mask = ((uint64_t)1 << s->memo_bits) - 1;
+    uint64_t at = key * 0x9e3779b97f4a7c15ull >> (64 - s->memo_bits);
+    for (range(probe, 0, ENUMERATE_PROBES, 1)) {
+        entry_t* entry = &s->memo[(at + probe) & mask];
+        uint64_t empty = 0;
+        if (atomic_compare_exchange_strong(
+                &entry->tag, &empty, ENUMERATE_FILLING)) {
+            entry->value = value;
+            atomic_store_explicit(
+                &entry->tag, key + 1, memory_order_release);
+            return;
+        }
+        // another thread got here first with the same position
+        if (empty == key + 1) return;
+    }
+}
+
+// seat 0's score once nobody can move, draws count half
+static double final_score(const pos_t* p) {
+    if (p->books[0] == p->books[1]) return 0.5;
+    return p->books[0] > p->books[1];
+}
+
+// book rank r for the mover, true if that ends the game
+static bool make_book(const search_t* s, pos_t* p, int mover, int r) {
+    p->in_hand[mover] -= p->held[mover][r];
+    p->held[mover][r] = 0;
+    p->booked[r] = 1 + mover;
+    p->books[mover]++;
+    return p->books[mover] >= s->to_win ||
+           p->books[0] + p->books[1] == s->ranks;
+}
+
+static void draw(pos_t* p, int seat, int r) {
+    p->held[seat][r]++;
+    p->deck[r]--;
+    p->in_hand[seat]++;
+    p->in_deck--;
+}
+
+/**
+ * @brief when sampling, the one rank a chance node (`counts` of each,
+ * out of `total`) comes up as, otherwise -1 to weigh them all
+ */
+static int sampled(search_t* s, const uint8_t* counts, int total) {
+    if (s->rng == NULL) return -1;
+    int at = rng_below(s->rng, total);
+    int r = 0;
+    while (at >= counts[r]) at -= counts[r++];
+    return r;
+}
+
+static double chance_of(int only, int r, int count, int total) {
+    if (only >= 0) return r == only;
+    return (double)count / total;
+}
+
+static double turn(search_t* s, const pos_t* p, int mover);
+
+// the mover asks for rank `want`
+static double resolve(search_t* s, const pos_t* p, int mover, int want) {
+    pos_t next = *p;
+    int   taken = next.held[!mover][want];
+
+    if (taken) {
+        next.held[!mover][want] = 0;
+        next.in_hand[!mover] -= taken;
+        next.held[mover][want] += taken;
+        next.in_hand[mover] += taken;
+        if (next.held[mover][want] < RULES_BOOK)
+            return turn(s, &next, !mover);
+        if (make_book(s, &next, mover, want)) return final_score(&next);
+        return turn(s, &next, mover);
+    }
+
+    if (next.in_deck == 0) {
+        if (next.held[mover][want] < RULES_BOOK)
+            return turn(s, &next, !mover);
+        if (make_book(s, &next, mover, want)) return final_score(&next);
+        return turn(s, &next, mover);
+    }
+
+    // go fish, the same order of events as play_turn
+    double value = 0;
+    int    only = sampled(s, p->deck, p->in_deck);
+    for (range(drawn, 0, s->ranks, 1)) {
+        double chance = chance_of(only, drawn, p->deck[drawn], p->in_deck);
+        if (chance == 0) continue;
+
+        pos_t fished = next;
+        draw(&fished, mover, drawn);
+        bool extra = drawn == want, over = false;
+        if (drawn != want && fished.held[mover][drawn] == RULES_BOOK) {
+            extra = true;
+            over = make_book(s, &fished, mover, drawn);
+        }
+        if (!over && fished.held[mover][want] == RULES_BOOK) {
+            extra = true;
+            over = make_book(s, &fished, mover, want);
+        }
+        value += chance * (over ? final_score(&fished)
+                                : turn(s, &fished, extra ? mover : !mover));
+    }
+    return value;
+}
+
+static double ask(search_t* s, const pos_t* p, int mover) {
+    const uint8_t* held = p->held[mover];
+
+    if (s->seats[mover] == LOCKSTEP_MOST) {
+        // the highest of the ranks held most, as bot_example_pick
+        int best = 0;
+        for (range(r, 1, s->ranks, 1))
+            if (held[r] >= held[best]) best = r;
+        return resolve(s, p, mover, best);
+    }
+
+    // a uniformly random card from the hand
+    double value = 0;
+    int    only = sampled(s, held, p->in_hand[mover]);
+    for (range(r, 0, s->ranks, 1)) {
+        double chance = chance_of(only, r, held[r], p->in_hand[mover]);
+        if (chance != 0) value += chance * resolve(s, p, mover, r);
+    }
+    return value;
+}
+
+/**
+ * @brief seat 0's expected score from the start of `mover`'s turn
+ */
+static double turn(search_t* s, const pos_t* p, int mover) {
+    uint64_t key = 0;
+    double   value = 0;
+    if (s->memo) {
+        key = pos_key(s, p, mover);
+        if (memo_find(s, key, &value)) {
+            s->hits++;
+            return value;
+        }
+    }
+    s->expanded++;
+
+    if (p->in_hand[mover]) {
+        value = ask(s, p, mover);
+    } else if (p->in_deck == 0) {
+        // nothing to ask with or draw, pass
+        value = p->in_hand[!mover] ? turn(s, p, !mover) : final_score(p);
+    } else {
+        // draw a card to ask with
+        int only = sampled(s, p->deck, p->in_deck);
+        for (range(r, 0, s->ranks, 1)) {
+            double chance = chance_of(only, r, p->deck[r], p->in_deck);
+            if (chance == 0) continue;
+            pos_t next = *p;
+            draw(&next, mover, r);
+            value += chance * ask(s, &next, mover);
+        }
+    }
+
+    if (s->memo) memo_keep(s, key, value);
+    return value;
+}
+
+/**
+ * @brief deal seat 1 `left` more cards from rank `slot` up, summing
+ * the ways to deal each hand times its value (applied and undone in
+ * place)
+ */
+static double deal_rest(
+    search_t* s,
+    pos_t*    p,
+    int       slot,
+    int       left,
+    double    ways  //
+) {
+    if (left == 0) return ways * turn(s, p, 0);
+    if (slot == s->ranks) return 0;
+
+    double sum = 0;
+    int    avail = p->deck[slot];
+    for (int count = 0; count <= avail && count <= left; count++) {
+        p->deck[slot] -= count;
+        p->held[1][slot] += count;
+        p->in_deck -= count;
+        p->in_hand[1] += count;
+        sum += deal_rest(
+            s, p, slot + 1, left - count, ways * choose[avail][count]);
+        p->deck[slot] += count;
+        p->held[1][slot] -= count;
+        p->in_deck += count;
+        p->in_hand[1] -= count;
+    }
+    return sum;
+}
+
+// every first hand, as the cards of each rank in it
+static void list_hands(
+    job_t*        job,
+    first_hand_t* building,
+    int           slot,
+    int           left,
+    double        ways  //
+) {
+    if (left == 0) {
+        building->chance =
+            ways / choose_big(job->rules->ranks * RULES_BOOK, job->hand);
+        job->hands[job->count++] = *building;
+        return;
+    }
+    if (slot == job->rules->ranks) return;
+    for (int count = 0; count <= RULES_BOOK && count <= left; count++) {
+        building->held[slot] = count;
+        list_hands(
+            job, building, slot + 1, left - count, ways * choose[4][count]);
+    }
+    building->held[slot] = 0;
+}
+
+static pos_t fresh_deck(int ranks) {
+    pos_t p = {0};
+    for (range(r, 0, ranks, 1)) p.deck[r] = RULES_BOOK;
+    p.in_deck = ranks * RULES_BOOK;
+    return p;
+}
+
+static void* worker(void* arg) {
+    job_t*   job = arg;
+    search_t s = *job->rules;
+
+    long idx;
+    while ((idx = atomic_fetch_add(&job->next, 1)) < job->count) {
+        pos_t p = fresh_deck(s.ranks);
+        for (range(r, 0, s.ranks, 1)) {
+            p.held[0][r] = job->hands[idx].held[r];
+            p.deck[r] -= p.held[0][r];
+        }
+        p.in_hand[0] = job->hand;
+        p.in_deck -= job->hand;
+
+        double second = choose_big(p.in_deck, job->hand);
+        job->values[idx] = job->hands[idx].chance *
+                           deal_rest(&s, &p, 0, job->hand, 1) / second;
+    }
+
+    atomic_fetch_add(&job->expanded, s.expanded);
+    atomic_fetch_add(&job->hits, s.hits);
+    return NULL;
+}
+
+/**
+ * @brief seat 0's exact expected score
+ */
+static double solve(job_t* job, search_t* rules, int threads) {
+    rules->memo_bits = ENUMERATE_MEMO_BITS(rules->ranks);
+    rules->memo = calloc((size_t)1 << rules->memo_bits, sizeof(entry_t));
+    if (rules->memo == NULL) ohcrap("out of memory for the memo table");
+    atomic_store(&job->next, 0);
+    pthread_t tids[threads];
+    for (range(idx, 0, threads, 1))
+        pthread_create(&tids[idx], NULL, &worker, job);
+    for (range(idx, 0, threads, 1)) pthread_join(tids[idx], NULL);
+
+    // summed in order so the result is the same on any number of threads
+    double total = 0;
+    for (long idx = 0; idx < job->count; idx++) total += job->values[idx];
+    free(rules->memo);
+    rules->memo = NULL;
+    return total;
+}
+
+// seat 0's mean score over sampled games, and its standard error
+static double sample(const search_t* rules, int hand, double* error) {
+    search_t s = *rules;
+    rng_t    rng;
+    rng_seed(&rng, ENUMERATE_SEED);
+    s.rng = &rng;
+
+    double sum = 0, squares = 0;
+    for (range(game, 0, ENUMERATE_SAMPLES, 1)) {
+        pos_t p = fresh_deck(s.ranks);
+        for (range(seat, 0, 2, 1))
+            for (range(card, 0, hand, 1))
+                draw(&p, seat, sampled(&s, p.deck, p.in_deck));
+        double score = turn(&s, &p, 0);
+        sum += score;
+        squares += score * score;
+    }
+    double mean = sum / ENUMERATE_SAMPLES;
+    *error = sqrt((squares / ENUMERATE_SAMPLES - mean * mean) /
+                  ENUMERATE_SAMPLES);
+    return mean;
+}
+
+// seat 0's mean score over games on the variant engine, which shares
+// no code with the search, and its standard error
+static double crosscheck(
+    const search_t* rules,
+    int             hand,
+    double*         error  //
+) {
+    rules_t variant = {hand, RULES_BOOK, rules->to_win};
+    double  sum = 0, squares = 0;
+    for (range(game, 0, ENUMERATE_SAMPLES, 1)) {
+        sim_result_t result = variant_play_ranks(
+            &variant, rules->seats, ENUMERATE_SEED, game, rules->ranks);
+        double score = result.books[0] == result.books[1] ? 0.5
+                       : result.winner == 0               ? 1
+                                                          : 0;
+        sum += score;
+        squares += score * score;
+    }
+    double mean = sum / ENUMERATE_SAMPLES;
+    *error = sqrt((squares / ENUMERATE_SAMPLES - mean * mean) /
+                  ENUMERATE_SAMPLES);
+    return mean;
+}
+
+int enumerate_run(const char* const specs[2], int ranks, int hand) {
+    lockstep_kind_t kinds[2];
+    for (range(idx, 0, 2, 1)) {
+        if (!lockstep_kind(specs[idx], &kinds[idx])) {
+            fprintf(
+                stderr,
+                "can't enumerate '%s', only random and most\n",
+                specs[idx]);
+            return 1;
+        }
+    }
+    if (ranks < 2 || ranks > ENUMERATE_MAX_RANKS)
+        ohcrap("enumerate between 2 and 6 ranks");
+    if (hand < 1 || 2 * hand >= ranks * RULES_BOOK)
+        ohcrap("the hands have to leave something in the deck");
+
+    search_t rules = {.ranks = ranks, .to_win = ranks / 2 + 1};
+    job_t    job = {.rules = &rules, .hand = hand};
+
+    // at most 5 ways per rank for the first hand
+    long most = 1;
+    for (range(r, 0, ranks, 1)) most *= RULES_BOOK + 1;
+    job.hands = malloc(most * sizeof(first_hand_t));
+    job.values = malloc(most * sizeof(double));
+    first_hand_t building = {0};
+    list_hands(&job, &building, 0, hand, 1);
+
+    int    threads = sim_threads();
+    double start = sim_now();
+    double scores[2];  // A's, moving first then second
+    for (range(first, 0, 2, 1)) {
+        rules.seats[0] = kinds[first];
+        rules.seats[1] = kinds[!first];
+        rules.symmetric = kinds[0] == LOCKSTEP_RANDOM &&
+                          kinds[1] == LOCKSTEP_RANDOM;
+        double seat0 = solve(&job, &rules, threads);
+        scores[first] = first ? 1 - seat0 : seat0;
+    }
+    double secs = sim_now() - start;
+    long   expanded = atomic_load(&job.expanded);
+    long   hits = atomic_load(&job.hits);
+
+    printf(
+        "%s vs %s, %i ranks, %i card hands, first to %i books:\n"
+        "%s's exact expected score (draws count half)\n"
+        "  moving first   %.9f\n"
+        "  moving second  %.9f\n"
+        "  overall        %.9f\n",
+        specs[0],
+        specs[1],
+        ranks,
+        hand,
+        rules.to_win,
+        specs[0],
+        scores[0],
+        scores[1],
+        (scores[0] + scores[1]) / 2);
+    printf(
+        "%li first hands (of %.0f ordered deals), %li positions solved, "
+        "%li memo hits\n"
+        "%.3fs on %i threads, %.0f positions/sec\n",
+        job.count,
+        choose_big(ranks * RULES_BOOK, 2 * hand) *
+            tgamma(2 * hand + 1),
+        expanded,
+        hits,
+        secs,
+        threads,
+        expanded / secs);
+
+    // the same rules again, sampled through the search's own code and
+    // played out on the variant engine
+    int failed = 0;
+    for (range(engine, 0, 2, 1)) {
+        for (range(first, 0, 2, 1)) {
+            rules.seats[0] = kinds[first];
+            rules.seats[1] = kinds[!first];
+            double error, seat0 = engine == 0
+                                      ? sample(&rules, hand, &error)
+                                      : crosscheck(&rules, hand, &error);
+            double mean = first ? 1 - seat0 : seat0;
+            bool   close = fabs(mean - scores[first]) <= 4 * error + 1e-12;
+            failed += !close;
+            printf(
+                "%s %i games moving %s: %.4f +- %.4f %s\n",
+                engine == 0 ? "sampled" : "variant engine",
+                ENUMERATE_SAMPLES,
+                first ? "second" : "first",
+                mean,
+                1.96 * error,
+                close ? "ok" : "DIFFERENT");
+        }
+    }
+
+    free(job.hands);
+    free(job.values);
+    return failed != 0;
+}
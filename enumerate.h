@@ -0,0 +1,73 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "lockstep.h"
+
+/** === [ Exhaustive enumeration ] ===
+ *
+ * Exact win chances for small games, for checking strategies and the
+ * simulators against. The deck is cut down to `ranks` ranks of 4 cards,
+ * each player is dealt `hand`, and the first to more than half the
+ * books wins (a draw, worth half, if they split an even number).
+ *
+ * Rather than walking every order of the deck, the search runs over
+ * chance nodes: a deal or a draw is a branch per rank left in the deck,
+ * weighted by how many of it are left, since which suit comes up never
+ * matters. A position is then just the cards of each rank in each hand,
+ * which ranks are booked and each side's books, which packs into a key
+ * for a memo table, so positions reached along different lines are
+ * solved once (and when neither side favours any rank, so are ones that
+ * only differ by relabelling the ranks). Players are
+ * the built in strategies whose choices only depend on their own hand
+ * ("random" asks from a uniformly random card, including in the
+ * endgame, "most" as usual), which keeps the game a Markov chain on
+ * those positions. Every move is applied to a copy of the position on
+ * the stack, so nothing is allocated along the way.
+ *
+ * The first player's possible hands are split between the threads,
+ * which share one memo table (entries are filled in once and never
+ * overwritten, so there's nothing to lock), and the per hand results
+ * are summed in a fixed order so the answer doesn't depend on the
+ * thread count. The numbers are checked against games sampled through
+ * the same code, and against games played out on the variant engine
+ * (see variant_play_ranks), which shares none of it, so the search's
+ * rules drifting from play_turn's shows up too.
+ */
+
+#define ENUMERATE_MAX_RANKS 6
+#define ENUMERATE_PROBES    16      // memo slots tried per position
+#define ENUMERATE_SAMPLES   200000  // sampled games to check against
+#define ENUMERATE_SEED      0x5eed  // seed for the sampled checks
+
+// memo entries (16 bytes each), log 2, each rank of the deck multiplies
+// the positions by about 16 so a 6 rank deck takes a GB
+#define ENUMERATE_MEMO_BITS(ranks) (4 * (ranks) + 2)
+
+/**
+ * @brief work out A's exact expected score against B (both ways round)
+ * on a deck of `ranks` ranks and report it with how long it took
+ *
+ * @return int process exit code
+ */
+int enumerate_run(const char* const specs[2], int ranks, int hand);
@@ -0,0 +1,166 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define _GNU_SOURCE
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+
+#include "frame.h"
+#include "check.h"
+
+// the longest a fragment gets: a name, every card, the books
+#define FRAGMENT_BYTES (64 + 52 * CARD_RENDER_MAX)
+
+typedef struct {
+    int    fd;
+    size_t length;
+    char   buf[FRAME_BYTES];
+} frame_t;
+
+typedef struct {
+    const player_t* player;
+    const char*     name;  // a new player can reuse an old one's memory
+    bool            hand_valid, books_valid;
+    card_mask_t     hand;
+    rank_t          books[RULES_TO_WIN];
+    char            hand_str[FRAGMENT_BYTES];
+    char            books_str[FRAGMENT_BYTES];
+} fragment_t;
+
+// the interactive game is one thread, everything else leaves game_out
+// NULL and never gets here
+static frame_t*   frame = NULL;
+static FILE*      frame_file = NULL;
+static fragment_t fragments[FRAME_PLAYERS];
+static int        next_fragment = 0;
+
+static void write_all(int fd, const char* buf, size_t length) {
+    while (length > 0) {
+        ssize_t wrote = write(fd, buf, length);
+        if (wrote < 0 && errno == EINTR) continue;
+        if (wrote <= 0) return;  // nowhere to report it
+        buf += wrote;
+        length -= wrote;
+    }
+}
+
+static ssize_t frame_write(void* cookie, const char* buf, size_t size) {
+    frame_t* into = cookie;
+    if (into->length + size > FRAME_BYTES) {
+        write_all(into->fd, into->buf, into->length);
+        into->length = 0;
+    }
+    if (size > FRAME_BYTES) {
+        write_all(into->fd, buf, size);
+        return size;
+    }
+    memcpy(&into->buf[into->length], buf, size);
+    into->length += size;
+    return size;
+}
+
+FILE* frame_open(int fd) {
+    if (frame_file != NULL) return frame_file;
+
+    frame = malloc(sizeof(frame_t));
+    frame->fd = fd;
+    frame->length = 0;
+    frame_file = fopencookie(
+        frame, "w", (cookie_io_functions_t){.write = &frame_write});
+    if (frame_file == NULL) ohcrap("unable to open the frame stream");
+    // the frame is the buffer, so stdio needn't keep another
+    setvbuf(frame_file, NULL, _IONBF, 0);
+    atexit(&frame_flush);
+    return frame_file;
+}
+
+void frame_flush() {
+    if (frame_file == NULL || game_out != frame_file) {
+        if (game_out != NULL) fflush(game_out);
+        return;
+    }
+    write_all(frame->fd, frame->buf, frame->length);
+    frame->length = 0;
+}
+
+static fragment_t* fragment_for(const player_t* const player) {
+    for (range(idx, 0, FRAME_PLAYERS, 1))
+        if (fragments[idx].player == player &&
+            fragments[idx].name == player->name)
+            return &fragments[idx];
+
+    fragment_t* fresh = &fragments[next_fragment];
+    next_fragment = (next_fragment + 1) % FRAME_PLAYERS;
+    fresh->player = player;
+    fresh->name = player->name;
+    fresh->hand_valid = fresh->books_valid = false;
+    return fresh;
+}
+
+const char* frame_hand(const player_t* const player) {
+    fragment_t* fragment = fragment_for(player);
+    card_mask_t hand = hand_mask(&player->hand);
+    if (fragment->hand_valid && fragment->hand == hand)
+        return fragment->hand_str;
+
+    char* at = fragment->hand_str;
+    at += sprintf(at, "%s's hand – ", player->name);
+    for (range(slot, 0, 13, 1))
+        for (range(suit, 0, 4, 1)) {
+            card_idx_t idx = suit * 13 + slot;
+            if (!(hand >> idx & 1)) continue;
+            const card_glyph_t* glyph =
+                card_glyph(card_from_idx(idx), false);
+            memcpy(at, glyph->str, glyph->length);
+            at += glyph->length;
+            *at++ = ' ';
+        }
+    strcpy(at, "\n");
+
+    fragment->hand = hand;
+    fragment->hand_valid = true;
+    return fragment->hand_str;
+}
+
+const char* frame_books(const player_t* const player) {
+    fragment_t* fragment = fragment_for(player);
+    if (fragment->books_valid &&
+        memcmp(fragment->books, player->books, sizeof(fragment->books)) == 0)
+        return fragment->books_str;
+
+    if (check_due()) check_books(player);
+    char* at = fragment->books_str;
+    at += sprintf(at, "%s's books – ", player->name);
+    for (range(idx, 0, RULES_TO_WIN, 1)) {
+        rank_t book = player->books[idx];
+        if (book != RANK_NULL) at += sprintf(at, "%-2s ", rank_as_str(book));
+    }
+    strcpy(at, "\n");
+
+    memcpy(fragment->books, player->books, sizeof(fragment->books));
+    fragment->books_valid = true;
+    return fragment->books_str;
+}
@@ -0,0 +1,66 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "player.h"
+
+/** === [ Frames ] ===
+ *
+ * The interactive game prints a turn as dozens of small pieces (the
+ * header, a hand card by card, the books rank by rank, the narration),
+ * and a terminal flushes every line, which over a slow remote terminal
+ * is most of the wait. Instead game_out can point at a frame: a stream
+ * that collects everything printed into one buffer, written out with a
+ * single write() just before the game waits for the user (frame_flush)
+ * and when the program exits.
+ *
+ * Hands and books are the bulk of every frame and barely change from
+ * one turn to the next, so each player's are rendered into a cached
+ * fragment, redrawn only when the cards in the hand (or the books)
+ * differ from last time. A hand's cards are shown in rank order, so
+ * the fragment only depends on which cards are held.
+ */
+
+#define FRAME_BYTES   65536  // collected before a write is forced
+#define FRAME_PLAYERS 2      // players with cached fragments
+
+/**
+ * @brief a stream collecting a frame for `fd`, for game_out
+ */
+FILE* frame_open(int fd);
+
+/**
+ * @brief write out everything collected so far in one go (or just
+ * fflush game_out if it isn't a frame)
+ */
+void frame_flush();
+
+/**
+ * @brief `name's hand – [cards]\n`, cached until the hand changes
+ */
+const char* frame_hand(const player_t* const);
+
+/**
+ * @brief `name's books – ranks\n`, cached until the books change
+ */
+const char* frame_books(const player_t* const);
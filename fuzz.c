@@ -0,0 +1,406 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "fuzz.h"
+
+#define ENGINES 2  // lockstep scalar, lockstep vector
+
+static const char* const engine_names[ENGINES] = {
+    "lockstep scalar",
+    "lockstep vector",
+};
+
+// the byte the mover's ask comes from, shared by every engine's turn
+typedef struct {
+    uint8_t byte;
+    bool    asked;  // whether the engine asked, so used the byte
+} pick_t;
+
+static int slot_for(uint8_t byte, card_mask_t held) {
+    if ((byte & 0x80) || held == 0) return byte % 13;
+    int nth = (byte & 0x7f) % __builtin_popcountll(held);
+    return card_idx_slot(card_mask_nth(held, nth));
+}
+
+static rank_t reference_read_rank(player_t* player) {
+    pick_t* pick = player->ctx;
+    pick->asked = true;
+    return slot_for(pick->byte, hand_mask(&player->hand)) + RANK_2;
+}
+
+static int lockstep_pick(card_mask_t held, void* ctx) {
+    pick_t* pick = ctx;
+    pick->asked = true;
+    return slot_for(pick->byte, held);
+}
+
+static const char* result_name(turn_result_t result) {
+    switch (result) {
+        case TURN_NEXT:
+            return "next";
+        case TURN_EXTRA:
+            return "extra";
+        case TURN_WON:
+            return "won";
+    }
+    return "?";
+}
+
+// what differs between the reference and an engine, false if nothing
+static bool differs(
+    const lockstep_state_t* const want,
+    const lockstep_state_t* const got,
+    bool                          won,
+    char* const                   what,
+    size_t                        size  //
+) {
+    for (range(seat, 0, 2, 1)) {
+        if (want->hand[seat] != got->hand[seat]) {
+            snprintf(
+                what,
+                size,
+                "seat %i's hand %013llx, not %013llx",
+                seat,
+                (unsigned long long)got->hand[seat],
+                (unsigned long long)want->hand[seat]);
+            return true;
+        }
+        if (want->booked[seat] != got->booked[seat]) {
+            snprintf(
+                what,
+                size,
+                "seat %i's books %04x, not %04x",
+                seat,
+                got->booked[seat],
+                want->booked[seat]);
+            return true;
+        }
+    }
+    if (want->remaining != got->remaining) {
+        snprintf(
+            what,
+            size,
+            "%i cards in the deck, not %i",
+            got->remaining,
+            want->remaining);
+        return true;
+    }
+    // a won game has no next move
+    if (!won && want->to_move != got->to_move) {
+        snprintf(what, size, "seat %i to move next", got->to_move);
+        return true;
+    }
+    return false;
+}
+
+err_t fuzz_case(
+    const uint8_t* const data,
+    size_t               size,
+    fuzz_report_t* const report  //
+) {
+    *report = (fuzz_report_t){0};
+    if (size < 8) return SUCCESS;
+
+    uint64_t game = 0;
+    for (range(idx, 0, 8, 1)) game |= (uint64_t)data[idx] << (8 * idx);
+    deck_t deck;
+    sim_deal(&deck, FUZZ_SEED, game, 1);
+
+    lockstep_game_t* engines[ENGINES];
+    for (range(idx, 0, ENGINES, 1))
+        engines[idx] = lockstep_game_start(&deck, idx == 1);
+
+    pick_t   pick;
+    player_t players[2] = {
+        player_init("Seat 0", true, &reference_read_rank),
+        player_init("Seat 1", true, &reference_read_rank),
+    };
+    players[0].ctx = &pick;
+    players[1].ctx = &pick;
+    player_seat(&players[0], &players[1], &deck);
+    player_deal_cards(&players[0], &deck, RULES_HAND);
+    player_deal_cards(&players[1], &deck, RULES_HAND);
+
+    size_t next = 8;
+    int    playing = 0;
+    bool   same = true;
+    while (same && next < size) {
+        pick = (pick_t){.byte = data[next]};
+        turn_result_t want = play_turn(
+            &players[playing],
+            &players[!playing],
+            &deck,
+            &players[0],
+            &players[1]);
+        bool asked = pick.asked;
+        next += asked;
+        report->turns++;
+        report->length = next;
+        if (want == TURN_NEXT) playing = !playing;
+
+        lockstep_state_t expected = {.remaining = deck.remaining};
+        expected.to_move = playing;
+        for (range(seat, 0, 2, 1)) {
+            expected.hand[seat] = hand_mask(&players[seat].hand);
+            expected.booked[seat] = player_booked_slots(&players[seat]);
+            if (players[seat].hand.length !=
+                (size_t)__builtin_popcountll(expected.hand[seat])) {
+                snprintf(
+                    report->what,
+                    sizeof(report->what),
+                    "play_turn: seat %i's hand has %zu nodes for %i cards",
+                    seat,
+                    players[seat].hand.length,
+                    __builtin_popcountll(expected.hand[seat]));
+                same = false;
+            }
+        }
+
+        for (range(idx, 0, ENGINES, 1)) {
+            if (!same) break;
+            pick = (pick_t){.byte = data[next - asked]};
+            turn_result_t got =
+                lockstep_game_turn(engines[idx], &lockstep_pick, &pick);
+            lockstep_state_t state = lockstep_game_state(engines[idx]);
+
+            char what[sizeof(report->what) - 24];
+            if (got != want) {
+                snprintf(
+                    what,
+                    sizeof(what),
+                    "turn result %s, not %s",
+                    result_name(got),
+                    result_name(want));
+                same = false;
+            } else if (pick.asked != asked) {
+                snprintf(
+                    what,
+                    sizeof(what),
+                    "%s where play_turn %s",
+                    pick.asked ? "asked" : "passed",
+                    asked ? "asked" : "passed");
+                same = false;
+            } else {
+                same = !differs(
+                    &expected, &state, want == TURN_WON, what, sizeof(what));
+            }
+            if (!same)
+                snprintf(
+                    report->what,
+                    sizeof(report->what),
+                    "%s: %s",
+                    engine_names[idx],
+                    what);
+        }
+        if (want == TURN_WON) break;
+    }
+
+    for (range(idx, 0, ENGINES, 1)) lockstep_game_end(engines[idx]);
+    player_cleanup(&players[0]);
+    player_cleanup(&players[1]);
+    return same;
+}
+
+static void print_hex(FILE* out, const uint8_t* data, size_t size) {
+    for (range(idx, 0, size, 1)) fprintf(out, "%02x", data[idx]);
+}
+
+static void print_mismatch(
+    FILE* const                out,
+    const uint8_t* const       data,
+    const fuzz_report_t* const report  //
+) {
+    fprintf(
+        out,
+        "turn %li differs, %s\nreplay with --fuzz-replay ",
+        report->turns,
+        report->what);
+    print_hex(out, data, report->length);
+    fprintf(out, "\n");
+}
+
+/* === [ random cases ] === */
+
+typedef struct {
+    long          cases;
+    uint64_t      seed;
+    _Atomic long  next_case;
+    _Atomic long  first_bad;  // the lowest mismatching case, or cases
+    _Atomic long  turns;
+} fuzz_t;
+
+static void random_case(uint64_t seed, long number, uint8_t* data) {
+    rng_t rng;
+    rng_keyed(&rng, seed, number, 0);
+    for (range(idx, 0, 8 + FUZZ_ASKS, 1)) data[idx] = rng_next(&rng);
+}
+
+static void* fuzz_worker(void* arg) {
+    fuzz_t* fuzz = arg;
+    uint8_t data[8 + FUZZ_ASKS];
+    long    turns = 0;
+
+    for (;;) {
+        long number = atomic_fetch_add(&fuzz->next_case, 1);
+        if (number >= atomic_load(&fuzz->first_bad)) break;
+
+        random_case(fuzz->seed, number, data);
+        fuzz_report_t report;
+        bool          same = fuzz_case(data, sizeof(data), &report);
+        turns += report.turns;
+        if (same) continue;
+
+        // keep the lowest, so which one is reported doesn't depend on
+        // the threads
+        long bad = atomic_load(&fuzz->first_bad);
+        while (number < bad &&
+               !atomic_compare_exchange_weak(&fuzz->first_bad, &bad, number))
+            ;
+    }
+    atomic_fetch_add(&fuzz->turns, turns);
+    return NULL;
+}
+
+int fuzz_run(long cases, uint64_t seed) {
+    if (cases <= 0) ohcrap("the number of cases must be positive");
+
+    fuzz_t fuzz = {.cases = cases, .seed = seed};
+    atomic_init(&fuzz.next_case, 0);
+    atomic_init(&fuzz.first_bad, cases);
+    atomic_init(&fuzz.turns, 0);
+
+    int       threads = sim_threads();
+    pthread_t tids[threads];
+    double    start = sim_now();
+    for (range(idx, 0, threads, 1))
+        pthread_create(&tids[idx], NULL, &fuzz_worker, &fuzz);
+    for (range(idx, 0, threads, 1)) pthread_join(tids[idx], NULL);
+    double secs = sim_now() - start;
+
+    long turns = atomic_load(&fuzz.turns);
+    long bad = atomic_load(&fuzz.first_bad);
+    printf(
+        "%li turns of %li cases compared on %i engines in %.3fs on %i "
+        "threads, %.0f turns/sec, seed %llu\n",
+        turns,
+        bad < cases ? bad + 1 : cases,
+        ENGINES,
+        secs,
+        threads,
+        turns / secs,
+        (unsigned long long)seed);
+    if (bad == cases) {
+        printf("no differences\n");
+        return 0;
+    }
+
+    uint8_t data[8 + FUZZ_ASKS];
+    random_case(seed, bad, data);
+    fuzz_report_t report;
+    fuzz_case(data, sizeof(data), &report);
+    printf("case %li: ", bad);
+    print_mismatch(stdout, data, &report);
+    return 1;
+}
+
+/* === [ replay ] === */
+
+static int hex_digit(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+// a file's bytes, or else the argument as hex, NULL if it's neither
+static uint8_t* read_case(const char* const arg, size_t* const size) {
+    FILE* file = fopen(arg, "rb");
+    if (file != NULL) {
+        size_t   cap = 4096, len = 0;
+        uint8_t* data = malloc(cap);
+        size_t   got;
+        while ((got = fread(&data[len], 1, cap - len, file)) > 0) {
+            len += got;
+            if (len == cap) data = realloc(data, cap *= 2);
+        }
+        fclose(file);
+        *size = len;
+        return data;
+    }
+
+    size_t   len = strlen(arg);
+    uint8_t* data = malloc(len / 2 + 1);
+    if (len % 2 != 0) {
+        free(data);
+        return NULL;
+    }
+    for (range(idx, 0, len / 2, 1)) {
+        int high = hex_digit(arg[2 * idx]);
+        int low = hex_digit(arg[2 * idx + 1]);
+        if (high < 0 || low < 0) {
+            free(data);
+            return NULL;
+        }
+        data[idx] = high << 4 | low;
+    }
+    *size = len / 2;
+    return data;
+}
+
+int fuzz_replay(const char* const arg) {
+    size_t   size;
+    uint8_t* data = read_case(arg, &size);
+    if (data == NULL) {
+        fprintf(stderr, "'%s' is neither a file nor a case in hex\n", arg);
+        return 1;
+    }
+
+    game_out = stdout;
+    fuzz_report_t report;
+    bool          same = fuzz_case(data, size, &report);
+    game_out = NULL;
+
+    if (same)
+        printf("%li turns, every engine agreed\n", report.turns);
+    else
+        print_mismatch(stdout, data, &report);
+    free(data);
+    return !same;
+}
+
+#ifdef GOFISH_LIBFUZZER
+int LLVMFuzzerTestOneInput(const uint8_t* data, size_t size) {
+    fuzz_report_t report;
+    if (!fuzz_case(data, size, &report)) {
+        print_mismatch(stderr, data, &report);
+        abort();
+    }
+    return 0;
+}
+#endif
@@ -0,0 +1,93 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "lockstep.h"
+
+/** === [ Differential fuzzing ] ===
+ *
+ * Plays the same game with the same asks on the reference engine
+ * (play_turn over player_t's linked list hands) and on the lockstep
+ * engine (asks resolved by its scalar code and by its AVX2 code), and
+ * compares the turn's result, both hands, both books, the deck and
+ * whose move it is after every turn.
+ *
+ * A case is a string of bytes:
+ *
+ *   bytes 0..7  the game number (little endian) of a run seeded with
+ *               FUZZ_SEED, which deals the deck (see sim_deal)
+ *   then        a byte per ask. With the top bit set it asks for rank
+ *               slot byte % 13 whether or not the mover holds any (an
+ *               ask for nothing, or for a booked rank, is a move
+ *               play_turn has to handle), otherwise for the rank of the
+ *               mover's (byte % cards held)'th card, in index order
+ *
+ * The case ends with the game or when its bytes run out, passed turns
+ * don't use a byte. A mismatch is reported as the case cut off at the
+ * turn that differs, which --fuzz-replay plays back narrated.
+ *
+ *   --fuzz <cases> [seed]         random cases, on every core
+ *   --fuzz-replay <hex | file>    one case, e.g. a libFuzzer crash file
+ *
+ * Built with -DGOFISH_LIBFUZZER (`make fuzz`, clang only) this file
+ * has libFuzzer's LLVMFuzzerTestOneInput instead of gofish.c having a
+ * main, and any mismatch aborts.
+ */
+
+#define FUZZ_SEED 0x60f154ull  // the run cases deal their decks from
+#define FUZZ_ASKS 512          // ask bytes in a random case
+
+/**
+ * @brief where a case went wrong
+ */
+typedef struct {
+    long   turns;      // turns played, up to and including the bad one
+    size_t length;     // bytes of the case those turns used
+    char   what[160];  // what differed, empty if nothing did
+} fuzz_report_t;
+
+/**
+ * @brief play a case on every engine
+ *
+ * @return err_t ERROR if any engine disagrees with play_turn
+ */
+err_t fuzz_case(
+    const uint8_t* const data,
+    size_t               size,
+    fuzz_report_t* const report);
+
+/**
+ * @brief `--fuzz`, play `cases` random cases and report the first
+ * (lowest numbered) mismatch
+ *
+ * @return int process exit code, 1 on a mismatch
+ */
+int fuzz_run(long cases, uint64_t seed);
+
+/**
+ * @brief `--fuzz-replay`, play one case with the game narrated
+ *
+ * @param arg a file holding the case, or the case in hex
+ * @return int process exit code, 1 on a mismatch
+ */
+int fuzz_replay(const char* const arg);
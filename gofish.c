@@ -15,44 +15,279 @@
  * less.
  */
 
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
 #include "gofish.h"
+#include "serve.h"
+#include "bot.h"
+#include "shm.h"
+#include "endgame.h"
+#include "tournament.h"
+#include "dealer.h"
+#include "lockstep.h"
+#include "simulate.h"
+#include "policy.h"
+#include "variant.h"
+#include "enumerate.h"
+#include "weights.h"
+#include "canon.h"
+#include "speculate.h"
+#include "frame.h"
+#include "metrics.h"
+#include "fuzz.h"
+#include "check.h"
+
+// a libFuzzer build (see fuzz.h) brings its own main
+#ifndef GOFISH_LIBFUZZER
+static void print_usage(const char* const exe) {
+    fprintf(
+        stderr,
+        "usage: %s                           play against the computer\n"
+        "       %s --serve <addr>            host tables on <addr>\n"
+        "       %s --loadgen <addr> <conns> <games> [idle]\n"
+        "       %s --bot <cmd> <games> [batch]  bot vs the computer\n"
+        "       %s --example-bot             a bot to try --bot with\n"
+        "       %s --shm <name> <cmd> <games>  shared memory strategy\n"
+        "       %s --shm-example-bot <name>  a strategy to try --shm with\n"
+        "       %s --endgame <positions>     solve random endgames\n"
+        "       %s --bench-render <hands>    time rendering hands\n"
+        "       %s --bench-deal <decks> [seed]  time the dealer thread\n"
+        "       %s --tournament <A> <B> [max games] [seed]\n"
+        "       %s --replay <A> <B> <seed> <game>  show one game of a run\n"
+        "       %s --check-threads <A> <B> <games> [seed]\n"
+        "       %s --lockstep <A> <B> <games> [seed]  check the batch "
+        "engine\n"
+        "       %s --simulate <A> <B> <games> [--seed N] [--threads N] "
+        "[--json]\n"
+        "             [--checkpoint <file> [--every secs]]\n"
+        "             [--shard <i>/<N> --checkpoint <file>]\n"
+        "             [--metrics <addr>]\n"
+        "       %s --simulate --resume <file> [--threads N] [--json]\n"
+        "       %s --merge <file>... [--json]  add up --shard results\n"
+        "       %s --stats <addr>            watch a --metrics run\n"
+        "       %s --fuzz <cases> [seed]     diff the engines turn by turn\n"
+        "       %s --fuzz-replay <hex | file>  replay a --fuzz case\n"
+        "       %s --train-policy <file> <games> [opponent] [seed]\n"
+        "       %s --variants <A> <B> <games> [seed]  sweep rule variants\n"
+        "       %s --enumerate <A> <B> <ranks> [hand]  exact odds, small "
+        "decks\n"
+        "       %s --canon <games> [seed]    time suit canonicalization\n"
+        "       %s --tune <file> <games> [opponent] [generations] [seed]\n"
+        "  <addr> is unix:<path> or tcp:<port> (loopback only)\n"
+        "  any of them can be led by --check off | sampled[:N] | full, how\n"
+        "  often to check the game's invariants (default sampled:1024)\n"
+        "  strategies (<A>, <B>) are one of:\n",
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe,
+        exe);
+    strategy_list(stderr);
+}
 
 /**
  * @brief Handles program entry and exit
  *
  * Initiates the first game and asking the user if/when they'd like to play
- * again
+ * again, or hands off to one of the headless modes
  *
  * @return int
  */
-int main(void) {
-    // player 1 is the user, player 2 is the computer
+int main(int argc, char** argv) {
+    // --check goes in front of everything else, and then is skipped
+    if (argc >= 3 && strcmp(argv[1], "--check") == 0) {
+        if (!check_configure(argv[2])) {
+            print_usage(argv[0]);
+            return 1;
+        }
+        argv[2] = argv[0];
+        argv += 2;
+        argc -= 2;
+    }
+
+    if (argc == 3 && strcmp(argv[1], "--serve") == 0)
+        return serve_run(argv[2]);
+
+    if ((argc == 5 || argc == 6) && strcmp(argv[1], "--loadgen") == 0)
+        return serve_loadgen(
+            argv[2],
+            atoi(argv[3]),
+            atoi(argv[4]),
+            argc == 6 ? atoi(argv[5]) : 0);
+
+    if ((argc == 4 || argc == 5) && strcmp(argv[1], "--bot") == 0)
+        return bot_play(
+            argv[2], atoi(argv[3]), argc == 5 ? atoi(argv[4]) : 0);
+
+    if (argc == 2 && strcmp(argv[1], "--example-bot") == 0)
+        return bot_example_main();
+
+    if (argc == 5 && strcmp(argv[1], "--shm") == 0)
+        return shm_play(argv[2], argv[3], atoi(argv[4]));
+
+    if (argc == 3 && strcmp(argv[1], "--shm-example-bot") == 0)
+        return shm_example_main(argv[2]);
+
+    if (argc == 3 && strcmp(argv[1], "--endgame") == 0)
+        return endgame_bench(atoi(argv[2]));
+
+    if (argc == 3 && strcmp(argv[1], "--bench-render") == 0)
+        return cards_render_bench(atoi(argv[2]));
+
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--bench-deal") == 0)
+        return dealer_bench(
+            atol(argv[2]),
+            argc == 4 ? strtoull(argv[3], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc >= 4 && argc <= 6 && strcmp(argv[1], "--tournament") == 0)
+        return tournament_run(
+            (const char* const[2]){argv[2], argv[3]},
+            argc >= 5 ? atol(argv[4]) : 1000000,
+            argc >= 6 ? strtoull(argv[5], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc == 6 && strcmp(argv[1], "--replay") == 0)
+        return sim_replay(
+            (const char* const[2]){argv[2], argv[3]},
+            strtoull(argv[4], NULL, 0),
+            strtoull(argv[5], NULL, 0));
+
+    if ((argc == 5 || argc == 6) && strcmp(argv[1], "--check-threads") == 0)
+        return sim_check_threads(
+            (const char* const[2]){argv[2], argv[3]},
+            atol(argv[4]),
+            argc == 6 ? strtoull(argv[5], NULL, 0) : (uint64_t)time(NULL));
+
+    if ((argc == 5 || argc == 6) && strcmp(argv[1], "--lockstep") == 0)
+        return lockstep_bench(
+            (const char* const[2]){argv[2], argv[3]},
+            atol(argv[4]),
+            argc == 6 ? strtoull(argv[5], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc >= 2 && strcmp(argv[1], "--simulate") == 0)
+        return simulate_main(argc - 2, argv + 2);
+
+    if (argc >= 2 && strcmp(argv[1], "--merge") == 0)
+        return simulate_merge(argc - 2, argv + 2);
+
+    if (argc == 3 && strcmp(argv[1], "--stats") == 0)
+        return metrics_dashboard(argv[2]);
+
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--fuzz") == 0)
+        return fuzz_run(
+            atol(argv[2]),
+            argc == 4 ? strtoull(argv[3], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc == 3 && strcmp(argv[1], "--fuzz-replay") == 0)
+        return fuzz_replay(argv[2]);
+
+    if ((argc == 5 || argc == 6) && strcmp(argv[1], "--variants") == 0)
+        return variant_sweep(
+            (const char* const[2]){argv[2], argv[3]},
+            atol(argv[4]),
+            argc == 6 ? strtoull(argv[5], NULL, 0) : (uint64_t)time(NULL));
+
+    if ((argc == 5 || argc == 6) && strcmp(argv[1], "--enumerate") == 0)
+        return enumerate_run(
+            (const char* const[2]){argv[2], argv[3]},
+            atoi(argv[4]),
+            argc == 6 ? atoi(argv[5]) : atoi(argv[4]));
+
+    if ((argc == 3 || argc == 4) && strcmp(argv[1], "--canon") == 0)
+        return canon_bench(
+            atol(argv[2]),
+            argc == 4 ? strtoull(argv[3], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc >= 4 && argc <= 7 && strcmp(argv[1], "--tune") == 0)
+        return weights_tune(
+            argv[2],
+            argc >= 5 ? argv[4] : "belief",
+            atol(argv[3]),
+            argc >= 6 ? atoi(argv[5]) : 20,
+            argc >= 7 ? strtoull(argv[6], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc >= 4 && argc <= 6 && strcmp(argv[1], "--train-policy") == 0)
+        return policy_train(
+            argv[2],
+            argc >= 5 ? argv[4] : "belief",
+            atol(argv[3]),
+            argc >= 6 ? strtoull(argv[5], NULL, 0) : (uint64_t)time(NULL));
+
+    if (argc != 1) {
+        print_usage(argv[0]);
+        return 1;
+    }
+
+    // player 1 is the user, player 2 is the computer, each turn's screen
+    // goes out in one write
+    game_out = frame_open(STDOUT_FILENO);
     do play_game();
     while (player_user_wants_to_play_again());
 }
+#endif  // GOFISH_LIBFUZZER
 
 void play_game() {
     // --- setup---
     // obligatory intro
-    printf("\n\n=== [ New Game ] ===\nShuffling deck...\n\n");
+    game_printf("\n\n=== [ New Game ] ===\nShuffling deck...\n\n");
 
-    player_t user = player_init("Player 1", true, &player_query_for_rank);
-    player_t compy = player_init("Player 2", false, &play_compy_turn);
+    // the compy's answers are worked out while the user is typing
+    speculation_t spec = speculate_init(&play_compy_belief_turn);
 
-    deck_t deck = {0};
+    player_t user = player_init("Player 1", true, &speculate_query_for_rank);
+    player_t compy = player_init("Player 2", false, &speculate_compy_turn);
+    deck_t   deck = {0};
+    user.ctx = &spec;
+    compy.ctx = &spec;
     deck_init(&deck);
     deck_shuffle(&deck);
 
-    player_deal_cards(&user, &deck, 7);
-    player_deal_cards(&compy, &deck, 7);
-
     // --- play ---
-    player_t* playing = &user;
-    player_t* other = &compy;
+    play_game_between(&user, &compy, &deck);
+
+    // --- cleanup ---
+    speculate_finish(&spec);
+    player_cleanup(&user);
+    player_cleanup(&compy);
+}
+
+player_t* play_game_between(
+    player_t* const first,
+    player_t* const second,
+    deck_t* const   deck  //
+) {
+    player_seat(first, second, deck);
+
+    player_deal_cards(first, deck, RULES_HAND);
+    player_deal_cards(second, deck, RULES_HAND);
+
+    player_t* playing = first;
+    player_t* other = second;
 
     player_t* player_that_won = NULL;  // nullable
     while (player_that_won == NULL) {
-        switch (play_turn(playing, other, &deck, &user, &compy)) {
+        switch (play_turn(playing, other, deck, first, second)) {
             case TURN_WON:
                 player_that_won = playing;
                 break;
@@ -67,12 +302,32 @@ void play_game() {
         }
     };
 
-    // --- cleanup ---
-    player_cleanup(&user);
-    player_cleanup(&user);
+    return player_that_won;
 }
 
-turn_result_t play_turn(
+bool play_turn_draw_up(player_t* const playing, deck_t* const deck) {
+    // if the player's hand is empty, draw a card if able
+    if (playing->hand.length != 0) return true;
+
+    card_t draw_up = CARD_NULL;
+    // the deck has cards
+    if (deck_deal(deck, &draw_up)) {
+        game_printf("%s has no cards, drawing...\n", playing->name);
+        hand_add_card(&playing->hand, draw_up);
+        belief_drew(&playing->seen);
+        return true;
+    }
+
+    // if they could not draw a card and have no cards pass the turn
+    game_printf(
+        "%s has no cards and cannot draw a card from an empty deck, "
+        "passing the turn...\n",
+        playing->name);
+    return false;
+}
+
+// play_turn, before the table is checked
+static turn_result_t play_turn_unchecked(
     player_t* const playing,
     player_t* const other,
     deck_t* const   deck,
@@ -80,26 +335,10 @@ turn_result_t play_turn(
     player_t* const compy_player  //
 ) {
     /* === [ Commence Turn ] === */
-    printf("=== %s's Turn ===\n", playing->name);
+    game_printf("=== %s's Turn ===\n", playing->name);
 
     /* --- [ empty hand ] --- */
-    // if the player's hand is empty, draw a card if able
-    card_t draw_up = CARD_NULL;
-    if (playing->hand.length == 0) {
-        // the deck has cards
-        if (deck_deal(deck, &draw_up)) {
-            printf("%s has no cards, drawing...\n", playing->name);
-            hand_add_card(&playing->hand, draw_up);
-        }
-        // if they could not draw a card and have no cards pass the turn
-        else {
-            printf(
-                "%s has no cards and cannot draw a card from an empty deck, "
-                "passing the turn...\n",
-                playing->name);
-            return TURN_NEXT;
-        }
-    }
+    if (!play_turn_draw_up(playing, deck)) return TURN_NEXT;
 
     // -- preamble / info --
 
@@ -109,7 +348,7 @@ turn_result_t play_turn(
 #endif
     player_print_books(user_player);
     player_print_books(compy_player);
-    printf("\n");
+    game_printf("\n");
 
     /* === [ Choose and Request a Rank ] === */
     turn_result_t result = TURN_NEXT;
@@ -126,13 +365,23 @@ turn_result_t play_turn(
     hand_search_remove_cards(
         &playing->hand, desired, &cards[other_count], &total);
 
+    // what the opponent saw: the rank asked for and what was handed over
+    // (RANK_NULL is the endgame's pass)
+    if (desired != RANK_NULL) {
+        card_mask_t given = 0;
+        for (range(idx, 0, other_count, 1))
+            given |= (card_mask_t)1 << card_idx(cards[idx]);
+        belief_asked(&playing->seen, desired, given);
+        belief_none_of(&other->seen, desired);
+    }
+
     // if the other player had cards
     if (other_count > 0) {
         char* a_cards_str;
 
         // print the other player's cards
         cards_asfmt(&a_cards_str, cards, 0, other_count);
-        printf(
+        game_printf(
             "    %s had " ESC_GRN "%s" ESC_RST "\n",
             other->name,
             a_cards_str);
@@ -140,7 +389,7 @@ turn_result_t play_turn(
 
         // print the current player's cards
         cards_asfmt(&a_cards_str, cards, other_count, total);
-        printf(
+        game_printf(
             "    %s had " ESC_GRN "%s" ESC_RST "\n",
             playing->name,
             a_cards_str);
@@ -149,7 +398,7 @@ turn_result_t play_turn(
     }
     // if the other player had none
     else {
-        printf(
+        game_printf(
             "    %s has no rank %s cards\n",
             other->name,
             rank_as_str(desired));
@@ -159,20 +408,21 @@ turn_result_t play_turn(
 
         card_pretty_str_t buf;
         if (deck_deal(deck, &drawn)) {
+            belief_drew(&playing->seen);
             card_sfmt(drawn, &buf);
-            printf(
+            game_printf(
                 "    Go fish! %s draws a card " ESC_GRN "%s" ESC_RST "\n",
                 playing->name,
                 playing->reveal_cards ? buf.str : "");
         } else {
-            printf("    Cannot go fish, the deck is empty\n");
+            game_printf("    Cannot go fish, the deck is empty\n");
         }
 
         // add the card to hand or book
         if (drawn.rank == desired) {
             result = TURN_EXTRA;
             cards[total++] = drawn;
-            printf(
+            game_printf(
                 "    %s drew the card they asked for %s%s%s\n",
                 playing->name,
                 ESC_GRN,
@@ -180,19 +430,23 @@ turn_result_t play_turn(
                 ESC_RST);
         } else if (  // this completes a book from what's in out hand
             drawn.rank != RANK_NULL &&
-            3 == hand_has_rank(&playing->hand, drawn.rank)  //
+            RULES_BOOK - 1 == hand_has_rank(&playing->hand, drawn.rank)
         ) {
             card_t drawn_book[7];
             int    book_sanity_check = 0;
             hand_search_remove_cards(
                 &playing->hand, drawn.rank, drawn_book, &book_sanity_check);
-            if (book_sanity_check != 3)
+            if (check_due() && book_sanity_check != RULES_BOOK - 1)
                 ohcrap("hand rank count mismatch, there're problems");
             if (player_add_book_did_win(playing, drawn.rank)) {
+                // the game's over, but the asked for cards still go
+                // back rather than vanish
+                for (range(idx, 0, total, 1))
+                    hand_add_card(&playing->hand, cards[idx]);
                 return TURN_WON;
             } else {
                 result = TURN_EXTRA;
-                printf(
+                game_printf(
                     "    %s drew the %s (making a the book of the %s "
                     "cards)\n",
                     playing->name,
@@ -202,21 +456,23 @@ turn_result_t play_turn(
         } else if (drawn.rank != RANK_NULL) {
             // then this card is cool but can just go right in our hand
             hand_add_card(&playing->hand, drawn);
-        } else  // the deck was empty
-            ;   // TODO handle no cards in deck;
+        }
+        // else the deck was empty, which means the other player has no
+        // cards of the rank only if this player holds all four, so the
+        // book is made below (see endgame.h)
     }
 
     // exit early if possible
     if (result == TURN_WON) {
-        printf("\n");
+        game_printf("\n");
         return result;
     }
 
-    if (total == 4) {  // it's a new book, do the add thing
+    if (total == RULES_BOOK) {  // it's a new book, do the add thing
         if (player_add_book_did_win(playing, desired)) {
             return TURN_WON;
         }
-        printf(
+        game_printf(
             "    %s made a book of the %s cards\n",
             playing->name,
             rank_as_str(desired));
@@ -227,9 +483,22 @@ turn_result_t play_turn(
     }
 
     if (result == TURN_EXTRA)
-        printf("    %s gets another turn\n", playing->name);
+        game_printf("    %s gets another turn\n", playing->name);
 
-    printf("\n");
+    game_printf("\n");
+    return result;
+}
+
+turn_result_t play_turn(
+    player_t* const playing,
+    player_t* const other,
+    deck_t* const   deck,
+    player_t* const user_player,
+    player_t* const compy_player  //
+) {
+    turn_result_t result = play_turn_unchecked(
+        playing, other, deck, user_player, compy_player);
+    if (check_due()) check_table(playing, other, deck);
     return result;
 }
 
@@ -253,4 +522,4 @@ turn_result_t play_turn(
 // BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
 // ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
 // CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
-// SOFTWARE.
\ No newline at end of file
+// SOFTWARE.
@@ -45,6 +45,32 @@ typedef enum {
  */
 void play_game();
 
+/**
+ * @brief seat, deal, and play one whole game from a shuffled deck
+ *
+ * `first` moves first and is treated as the user when printing. The
+ * players should have empty hands, cleaning them up afterwards is left
+ * to the caller.
+ *
+ * @return the player that won
+ */
+player_t* play_game_between(
+    player_t* const first,
+    player_t* const second,
+    deck_t* const   deck);
+
+/**
+ * @brief the start of every turn: a player with an empty hand draws a
+ * card if the deck has one
+ *
+ * Already done by play_turn, this is split out so callers that need to
+ * know what a player will be asked with (the server) can run it first.
+ *
+ * @return true if the player has cards to ask with, false if the turn
+ * must be passed
+ */
+bool play_turn_draw_up(player_t* const playing, deck_t* const deck);
+
 turn_result_t play_turn(
     player_t* const playing,
     player_t* const other,
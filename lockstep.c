@@ -0,0 +1,630 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#if defined(__x86_64__)
+#include <immintrin.h>
+#endif
+
+#include "lockstep.h"
+#include "endgame.h"
+
+// what resolving a lane's ask did, see resolve_scalar
+#define DID_DRAW      1
+#define DID_BOOK_TOP  2
+#define DID_BOOK_WANT 4
+#define DID_EXTRA     8
+
+typedef struct {
+    // game state
+    card_mask_t hand[2][LOCKSTEP_LANES];
+    uint16_t    booked[2][LOCKSTEP_LANES];  // rank slots booked by seat
+    card_idx_t  deck[LOCKSTEP_LANES][52];
+    uint8_t     remaining[LOCKSTEP_LANES];
+    uint8_t     to_move[LOCKSTEP_LANES];
+    uint16_t    turns[LOCKSTEP_LANES];
+    uint16_t    first_book[LOCKSTEP_LANES];
+    uint8_t     streak[LOCKSTEP_LANES];  // TURN_EXTRAs in a row so far
+    uint8_t     longest[LOCKSTEP_LANES];
+    long        game[LOCKSTEP_LANES];  // index into the results
+    rng_t       rng[2][LOCKSTEP_LANES];
+    uint8_t     kind[2][LOCKSTEP_LANES];  // lockstep_kind_t by seat
+
+    // this step's asks, written by choose and read by resolve
+    uint64_t    asking[LOCKSTEP_LANES];  // all ones if the lane asks
+    uint64_t    seat1[LOCKSTEP_LANES];   // all ones if seat 1 moves
+    card_mask_t want[LOCKSTEP_LANES];    // the asked for rank's cards
+    uint64_t    want_slot[LOCKSTEP_LANES];
+    card_mask_t top[LOCKSTEP_LANES];  // the deck's top card, 0 if empty
+    card_mask_t top_rank[LOCKSTEP_LANES];  // its rank's cards
+    uint64_t    top_slot[LOCKSTEP_LANES];
+    uint64_t    did[LOCKSTEP_LANES];  // DID_* flags, written by resolve
+
+    uint64_t active;  // lanes with a game in them
+} lanes_t;
+
+typedef void (*resolve_fn)(lanes_t* const);
+
+err_t lockstep_kind(const char* const spec, lockstep_kind_t* const into) {
+    if (strcmp(spec, "random") == 0) {
+        *into = LOCKSTEP_RANDOM;
+        return SUCCESS;
+    }
+    if (strcmp(spec, "most") == 0) {
+        *into = LOCKSTEP_MOST;
+        return SUCCESS;
+    }
+    return ERROR;
+}
+
+// the run being played, and where its results go
+typedef struct {
+    lockstep_kind_t     seats[2];
+    bool                swap_odd;
+    uint64_t            seed;
+    uint64_t            first;
+    long                games;
+    long                next;  // the next game to load, from first
+    sim_result_t*       results;
+} run_t;
+
+// start a game in a lane from a dealt deck, seat 0 to move
+static void lane_deal(
+    lanes_t* const      lanes,
+    int                 lane,
+    const deck_t* const deck  //
+) {
+    memcpy(lanes->deck[lane], deck->cards, 52);
+
+    // RULES_HAND each off the top, seat 0 first, like sim_play
+    uint8_t remaining = deck->remaining;
+    for (range(seat, 0, 2, 1)) {
+        lanes->hand[seat][lane] = 0;
+        for (range(_, 0, RULES_HAND, 1))
+            lanes->hand[seat][lane] |= (card_mask_t)1
+                                       << lanes->deck[lane][--remaining];
+        lanes->booked[seat][lane] = 0;
+    }
+    lanes->remaining[lane] = remaining;
+    lanes->to_move[lane] = 0;
+    lanes->turns[lane] = 0;
+    lanes->first_book[lane] = 0;
+    lanes->streak[lane] = 0;
+    lanes->longest[lane] = 0;
+    lanes->active |= (uint64_t)1 << lane;
+}
+
+static void lane_load(lanes_t* const lanes, int lane, run_t* const run) {
+    long     result_idx = run->next++;
+    uint64_t game = run->first + result_idx;
+    uint64_t seed = run->seed;
+    bool     swap = run->swap_odd && (game & 1);
+
+    deck_t deck;
+    sim_deal(&deck, seed, game, 1);
+    lane_deal(lanes, lane, &deck);
+    for (range(seat, 0, 2, 1)) {
+        lanes->kind[seat][lane] = run->seats[seat ^ swap];
+        rng_keyed(
+            &lanes->rng[seat][lane], seed, game, SIM_STREAM_SEAT + seat);
+    }
+    lanes->game[lane] = result_idx;
+}
+
+// the rank slot a strategy asks for, the same as its read_rank would
+static int choose_slot(
+    lanes_t* const  lanes,
+    int             lane,
+    lockstep_kind_t kind,
+    int             seat  //
+) {
+    card_mask_t held = lanes->hand[seat][lane];
+
+    if (kind == LOCKSTEP_MOST) {
+        int best = 0, best_count = -1;
+        for (range(slot, 0, 13, 1)) {
+            int count = __builtin_popcountll(held & card_mask_rank(slot));
+            if (count >= best_count) {
+                best = slot;
+                best_count = count;
+            }
+        }
+        return best;
+    }
+
+    // the random strategy solves the endgame once the deck is out
+    if (lanes->remaining[lane] == 0) {
+        uint8_t  counts[13];
+        bool     booked[13];
+        uint16_t either =
+            lanes->booked[0][lane] | lanes->booked[1][lane];
+        for (range(slot, 0, 13, 1)) {
+            counts[slot] = __builtin_popcountll(held & card_mask_rank(slot));
+            booked[slot] = (either >> slot) & 1;
+        }
+        endgame_key_t key = endgame_key(
+            counts,
+            booked,
+            __builtin_popcount(lanes->booked[seat][lane]),
+            __builtin_popcount(lanes->booked[!seat][lane]));
+        return endgame_solve(key).best - RANK_2;
+    }
+
+    int nth = rng_below(&lanes->rng[seat][lane], __builtin_popcountll(held));
+    return card_idx_slot(card_mask_nth(held, nth));
+}
+
+// start the turn of the lane's mover, drawing up an empty hand, false
+// if they have to pass (see play_turn_draw_up)
+static bool lane_draw_up(lanes_t* const lanes, int lane) {
+    int seat = lanes->to_move[lane];
+    lanes->turns[lane]++;
+    lanes->asking[lane] = 0;
+    lanes->seat1[lane] = seat ? ~(uint64_t)0 : 0;
+
+    if (lanes->hand[seat][lane] != 0) return true;
+    if (lanes->remaining[lane] == 0) return false;
+    card_idx_t card = lanes->deck[lane][--lanes->remaining[lane]];
+    lanes->hand[seat][lane] |= (card_mask_t)1 << card;
+    return true;
+}
+
+// the lane's mover asks for a rank slot
+static void lane_ask(lanes_t* const lanes, int lane, int slot) {
+    lanes->asking[lane] = ~(uint64_t)0;
+    lanes->want[lane] = card_mask_rank(slot);
+    lanes->want_slot[lane] = slot;
+
+    if (lanes->remaining[lane] != 0) {
+        card_idx_t top = lanes->deck[lane][lanes->remaining[lane] - 1];
+        lanes->top[lane] = (card_mask_t)1 << top;
+        lanes->top_slot[lane] = card_idx_slot(top);
+        lanes->top_rank[lane] = card_mask_rank(card_idx_slot(top));
+    } else {
+        lanes->top[lane] = 0;
+        lanes->top_slot[lane] = 0;
+        lanes->top_rank[lane] = 0;
+    }
+}
+
+// phase 1, per lane: draw up an empty hand and pick the rank to ask for
+static void choose(lanes_t* const lanes) {
+    for (uint64_t left = lanes->active; left != 0; left &= left - 1) {
+        int lane = __builtin_ctzll(left);
+        int seat = lanes->to_move[lane];
+        if (!lane_draw_up(lanes, lane)) continue;
+        lane_ask(
+            lanes,
+            lane,
+            choose_slot(lanes, lane, lanes->kind[seat][lane], seat));
+    }
+}
+
+// how many of a rank's 4 cards are in mask, given the rank's slot
+static inline int count_rank(card_mask_t mask, int slot) {
+    card_mask_t at = mask >> slot;
+    return (at & 1) + (at >> 13 & 1) + (at >> 26 & 1) + (at >> 39 & 1);
+}
+
+/**
+ * phase 2, every asking lane: the rest of play_turn, as masks
+ *
+ *  - take the asked for rank from the opponent, if they have none go
+ *    fish (the top card, if there is one)
+ *  - a fished card of the asked for rank goes with the asked for cards,
+ *    one that makes 4 of another rank books that rank, otherwise it
+ *    goes in the hand
+ *  - 4 of the asked for rank books it, otherwise they go in the hand
+ */
+static void resolve_scalar(lanes_t* const lanes) {
+    for (range(lane, 0, LOCKSTEP_LANES, 1)) {
+        if (!lanes->asking[lane]) continue;
+        int         seat = lanes->seat1[lane] & 1;
+        card_mask_t me = lanes->hand[seat][lane];
+        card_mask_t them = lanes->hand[!seat][lane];
+        card_mask_t want = lanes->want[lane];
+        card_mask_t top = lanes->top[lane];
+
+        card_mask_t taken = them & want;
+        bool        drew = taken == 0 && top != 0;
+        bool        drew_wanted = drew && (top & want) != 0;
+        bool        book_top =
+            drew && !drew_wanted &&
+            count_rank(me & lanes->top_rank[lane], lanes->top_slot[lane]) ==
+                3;
+        card_mask_t pool = taken | (me & want) | (drew_wanted ? top : 0);
+        bool book_want = count_rank(pool, lanes->want_slot[lane]) == 4;
+
+        me &= ~want;
+        them &= ~want;
+        if (drew && !drew_wanted && !book_top) me |= top;
+        if (book_top) me &= ~lanes->top_rank[lane];
+        if (!book_want) me |= pool;
+
+        lanes->hand[seat][lane] = me;
+        lanes->hand[!seat][lane] = them;
+        lanes->did[lane] = (drew ? DID_DRAW : 0) |
+                           (book_top ? DID_BOOK_TOP : 0) |
+                           (book_want ? DID_BOOK_WANT : 0) |
+                           (drew_wanted || book_top || book_want ? DID_EXTRA
+                                                                 : 0);
+    }
+}
+
+#if defined(__x86_64__)
+// count_rank for 4 lanes
+__attribute__((target("avx2"))) static inline __m256i count_rank4(
+    __m256i mask,
+    __m256i slot  //
+) {
+    __m256i one = _mm256_set1_epi64x(1);
+    __m256i at = _mm256_srlv_epi64(mask, slot);
+    __m256i count = _mm256_and_si256(at, one);
+    count = _mm256_add_epi64(
+        count, _mm256_and_si256(_mm256_srli_epi64(at, 13), one));
+    count = _mm256_add_epi64(
+        count, _mm256_and_si256(_mm256_srli_epi64(at, 26), one));
+    return _mm256_add_epi64(
+        count, _mm256_and_si256(_mm256_srli_epi64(at, 39), one));
+}
+
+// resolve_scalar, 4 lanes at a time, branches become lane masks
+__attribute__((target("avx2"))) static void resolve_avx2(
+    lanes_t* const lanes  //
+) {
+    const __m256i zero = _mm256_setzero_si256();
+
+#define LOAD(field) _mm256_loadu_si256((const __m256i*)&lanes->field[lane])
+#define STORE(field, value) \
+    _mm256_storeu_si256((__m256i*)&lanes->field[lane], value)
+#define IS_ZERO(value)     _mm256_cmpeq_epi64(value, zero)
+#define FLAG(when, flag) \
+    _mm256_and_si256(when, _mm256_set1_epi64x(flag))
+
+    for (int lane = 0; lane < LOCKSTEP_LANES; lane += 4) {
+        __m256i asking = LOAD(asking);
+        if (_mm256_testz_si256(asking, asking)) continue;
+
+        __m256i seat1 = LOAD(seat1);
+        __m256i hand0 = LOAD(hand[0]);
+        __m256i hand1 = LOAD(hand[1]);
+        __m256i me = _mm256_blendv_epi8(hand0, hand1, seat1);
+        __m256i them = _mm256_blendv_epi8(hand1, hand0, seat1);
+        __m256i want = LOAD(want);
+        __m256i top = LOAD(top);
+        __m256i top_rank = LOAD(top_rank);
+
+        __m256i taken = _mm256_and_si256(them, want);
+        __m256i drew = _mm256_andnot_si256(IS_ZERO(top), IS_ZERO(taken));
+        __m256i drew_wanted = _mm256_andnot_si256(
+            IS_ZERO(_mm256_and_si256(top, want)), drew);
+        __m256i drew_other = _mm256_andnot_si256(drew_wanted, drew);
+        __m256i book_top = _mm256_and_si256(
+            drew_other,
+            _mm256_cmpeq_epi64(
+                count_rank4(_mm256_and_si256(me, top_rank), LOAD(top_slot)),
+                _mm256_set1_epi64x(3)));
+        __m256i pool = _mm256_or_si256(
+            _mm256_or_si256(taken, _mm256_and_si256(me, want)),
+            _mm256_and_si256(drew_wanted, top));
+        __m256i book_want = _mm256_cmpeq_epi64(
+            count_rank4(pool, LOAD(want_slot)), _mm256_set1_epi64x(4));
+
+        me = _mm256_andnot_si256(want, me);
+        them = _mm256_andnot_si256(want, them);
+        __m256i keep_top = _mm256_andnot_si256(book_top, drew_other);
+        me = _mm256_or_si256(me, _mm256_and_si256(keep_top, top));
+        me = _mm256_andnot_si256(_mm256_and_si256(book_top, top_rank), me);
+        me = _mm256_or_si256(me, _mm256_andnot_si256(book_want, pool));
+
+        // lanes that aren't asking keep their hands
+        __m256i new0 = _mm256_blendv_epi8(me, them, seat1);
+        __m256i new1 = _mm256_blendv_epi8(them, me, seat1);
+        STORE(hand[0], _mm256_blendv_epi8(hand0, new0, asking));
+        STORE(hand[1], _mm256_blendv_epi8(hand1, new1, asking));
+
+        __m256i extra = _mm256_or_si256(
+            drew_wanted, _mm256_or_si256(book_top, book_want));
+        __m256i did = _mm256_or_si256(
+            _mm256_or_si256(
+                FLAG(drew, DID_DRAW), FLAG(book_top, DID_BOOK_TOP)),
+            _mm256_or_si256(
+                FLAG(book_want, DID_BOOK_WANT), FLAG(extra, DID_EXTRA)));
+        STORE(did, _mm256_and_si256(did, asking));
+    }
+
+#undef LOAD
+#undef STORE
+#undef IS_ZERO
+#undef FLAG
+}
+#endif
+
+// adds a book for seat, true if that won the game
+static inline bool add_book(
+    lanes_t* const lanes,
+    int            lane,
+    int            seat,
+    int            slot  //
+) {
+    lanes->booked[seat][lane] |= 1 << slot;
+    return __builtin_popcount(lanes->booked[seat][lane]) == RULES_TO_WIN;
+}
+
+// phase 3, per lane: books, the next player, and finished games
+static void finish(lanes_t* const lanes, run_t* const run) {
+    for (uint64_t left = lanes->active; left != 0; left &= left - 1) {
+        int lane = __builtin_ctzll(left);
+        int seat = lanes->to_move[lane];
+
+        if (!lanes->asking[lane]) {
+            lanes->to_move[lane] = !seat;
+            lanes->streak[lane] = 0;
+            continue;
+        }
+
+        uint64_t did = lanes->did[lane];
+        if (did & DID_DRAW) lanes->remaining[lane]--;
+
+        // the fished book first, play_turn stops as soon as one wins
+        bool won = (did & DID_BOOK_TOP) &&
+                   add_book(lanes, lane, seat, lanes->top_slot[lane]);
+        if (!won && (did & DID_BOOK_WANT))
+            won = add_book(lanes, lane, seat, lanes->want_slot[lane]);
+
+        if (lanes->first_book[lane] == 0 && lanes->booked[seat][lane] != 0)
+            lanes->first_book[lane] = lanes->turns[lane];
+
+        if (!won) {
+            if (!(did & DID_EXTRA)) {
+                lanes->to_move[lane] = !seat;
+                lanes->streak[lane] = 0;
+            } else if (++lanes->streak[lane] > lanes->longest[lane]) {
+                lanes->longest[lane] = lanes->streak[lane];
+            }
+            continue;
+        }
+
+        run->results[lanes->game[lane]] = (sim_result_t){
+            .winner = seat,
+            .books = {
+                __builtin_popcount(lanes->booked[0][lane]),
+                __builtin_popcount(lanes->booked[1][lane]),
+            },
+            .turns = lanes->turns[lane],
+            .booked = {lanes->booked[0][lane], lanes->booked[1][lane]},
+            .first_book = lanes->first_book[lane],
+            .streak = lanes->longest[lane],
+        };
+
+        lanes->active &= ~((uint64_t)1 << lane);
+        lanes->asking[lane] = 0;
+        if (run->next < run->games) lane_load(lanes, lane, run);
+    }
+}
+
+static void play_with(resolve_fn resolve, run_t* const run) {
+    lanes_t* lanes = calloc(1, sizeof(lanes_t));
+    if (lanes == NULL) ohcrap("could not allocate the lockstep lanes");
+
+    for (range(lane, 0, LOCKSTEP_LANES, 1))
+        if (run->next < run->games) lane_load(lanes, lane, run);
+
+    while (lanes->active != 0) {
+        choose(lanes);
+        resolve(lanes);
+        finish(lanes, run);
+    }
+    free(lanes);
+}
+
+static bool have_avx2() {
+#if defined(__x86_64__)
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+static resolve_fn best_resolve() {
+#if defined(__x86_64__)
+    if (have_avx2()) return &resolve_avx2;
+#endif
+    return &resolve_scalar;
+}
+
+void lockstep_play(
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              first,
+    long                  games,
+    bool                  swap_odd,
+    sim_result_t* const   results  //
+) {
+    run_t run = {
+        .seats = {seats[0], seats[1]},
+        .swap_odd = swap_odd,
+        .seed = seed,
+        .first = first,
+        .games = games,
+        .results = results,
+    };
+    play_with(best_resolve(), &run);
+}
+
+struct lockstep_game {
+    lanes_t    lanes;  // the game is in lane 0
+    resolve_fn resolve;
+};
+
+lockstep_game_t* lockstep_game_start(
+    const deck_t* const dealt,
+    bool                vector  //
+) {
+    lockstep_game_t* game = calloc(1, sizeof(lockstep_game_t));
+    if (game == NULL) ohcrap("could not allocate a lockstep game");
+    game->resolve = vector ? best_resolve() : &resolve_scalar;
+    lane_deal(&game->lanes, 0, dealt);
+    return game;
+}
+
+turn_result_t lockstep_game_turn(
+    lockstep_game_t* const game,
+    int (*pick)(card_mask_t held, void* ctx),
+    void* ctx  //
+) {
+    lanes_t* lanes = &game->lanes;
+    int      seat = lanes->to_move[0];
+    if (lanes->active == 0) ohcrap("that lockstep game is over");
+
+    if (lane_draw_up(lanes, 0))
+        lane_ask(lanes, 0, pick(lanes->hand[seat][0], ctx));
+    bool asked = lanes->asking[0] != 0;
+    game->resolve(lanes);
+
+    // with no games left to load, a won game just leaves its lane
+    sim_result_t result;
+    run_t        run = {.results = &result};
+    finish(lanes, &run);
+
+    if (lanes->active == 0) return TURN_WON;
+    return asked && lanes->to_move[0] == seat ? TURN_EXTRA : TURN_NEXT;
+}
+
+lockstep_state_t lockstep_game_state(const lockstep_game_t* const game) {
+    const lanes_t* lanes = &game->lanes;
+    return (lockstep_state_t){
+        .hand = {lanes->hand[0][0], lanes->hand[1][0]},
+        .booked = {lanes->booked[0][0], lanes->booked[1][0]},
+        .remaining = lanes->remaining[0],
+        .to_move = lanes->to_move[0],
+    };
+}
+
+void lockstep_game_end(lockstep_game_t* const game) { free(game); }
+
+// the first game two result sets disagree on, -1 if none
+static long first_difference(
+    const sim_result_t* a,
+    const sim_result_t* b,
+    long                games  //
+) {
+    for (long game = 0; game < games; game++)
+        if (a[game].winner != b[game].winner ||
+            a[game].books[0] != b[game].books[0] ||
+            a[game].books[1] != b[game].books[1] ||
+            a[game].turns != b[game].turns ||
+            a[game].booked[0] != b[game].booked[0] ||
+            a[game].booked[1] != b[game].booked[1] ||
+            a[game].first_book != b[game].first_book ||
+            a[game].streak != b[game].streak)
+            return game;
+    return -1;
+}
+
+int lockstep_bench(
+    const char* const specs[2],
+    long              games,
+    uint64_t          seed  //
+) {
+    lockstep_kind_t kinds[2];
+    strategy_t      opened[2];
+    for (range(idx, 0, 2, 1)) {
+        if (!lockstep_kind(specs[idx], &kinds[idx])) {
+            fprintf(
+                stderr,
+                "the lockstep engine can't play '%s', only random and "
+                "most\n",
+                specs[idx]);
+            return 1;
+        }
+        strategy_open(specs[idx], &opened[idx]);
+    }
+    if (games <= 0) ohcrap("the number of games must be positive");
+
+    sim_result_t* expected = calloc(games, sizeof(sim_result_t));
+    sim_result_t* got = calloc(games, sizeof(sim_result_t));
+    int           failed = 0;
+
+    // odd games swap the seats, so both kinds play both seats
+    const strategy_t* seats[2][2] = {
+        {&opened[0], &opened[1]},
+        {&opened[1], &opened[0]},
+    };
+    double start = sim_now();
+    for (long game = 0; game < games; game++)
+        expected[game] = sim_play(seats[game & 1], seed, game);
+    double play_turn_secs = sim_now() - start;
+    printf(
+        "play_turn:         %10.0f games/sec\n", games / play_turn_secs);
+
+    struct {
+        const char* name;
+        resolve_fn  resolve;
+        bool        usable;
+    } engines[] = {
+        {"lockstep scalar:", &resolve_scalar, true},
+#if defined(__x86_64__)
+        {"lockstep avx2:", &resolve_avx2, have_avx2()},
+#endif
+    };
+
+    for (range(idx, 0, sizeof(engines) / sizeof(engines[0]), 1)) {
+        if (!engines[idx].usable) {
+            printf("%-18s this CPU has no AVX2\n", engines[idx].name);
+            continue;
+        }
+
+        memset(got, 0, games * sizeof(sim_result_t));
+        start = sim_now();
+        run_t run = {
+            .seats = {kinds[0], kinds[1]},
+            .swap_odd = true,
+            .seed = seed,
+            .games = games,
+            .results = got,
+        };
+        play_with(engines[idx].resolve, &run);
+        double secs = sim_now() - start;
+
+        long differs = first_difference(expected, got, games);
+        failed += differs >= 0;
+        printf(
+            "%-18s %10.0f games/sec (%.1fx), ",
+            engines[idx].name,
+            games / secs,
+            play_turn_secs / secs);
+        if (differs < 0)
+            printf("all %li games match\n", games);
+        else
+            printf("game %li differs\n", differs);
+    }
+
+    strategy_close(&opened[0]);
+    strategy_close(&opened[1]);
+    free(expected);
+    free(got);
+    return failed != 0;
+}
@@ -0,0 +1,126 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "sim.h"
+
+/** === [ Lockstep engine ] ===
+ *
+ * A second implementation of the game for bulk simulation. Instead of
+ * one game at a time through play_turn, LOCKSTEP_LANES games advance
+ * together one turn per step, with their state kept as arrays of the
+ * same field (structure of arrays): hands and books are bitmasks (see
+ * card_mask_t), the deck is a cursor into each game's dealt order.
+ *
+ * Each step has three phases. Choosing ranks (which needs the rng or
+ * the endgame solver) and applying books run per game, between them
+ * resolving every game's ask at once (taking cards, going fish, making
+ * books) is straight line mask arithmetic, done 4 games to an AVX2
+ * vector when the CPU has it and with the same logic one game at a time
+ * when it doesn't. A finished game's lane is refilled with the next
+ * game; once there are none left its lane is masked off.
+ *
+ * It plays exactly the games sim_play does (same seed, same game
+ * number, same result) for the built in strategies it knows, which
+ * `--lockstep` checks game for game.
+ */
+
+#define LOCKSTEP_LANES 64  // games in flight, a multiple of 4
+
+/**
+ * @brief the strategies the lockstep engine can play
+ */
+typedef enum {
+    LOCKSTEP_RANDOM,  // "random", see play_compy_turn
+    LOCKSTEP_MOST,    // "most", see bot_example_pick
+} lockstep_kind_t;
+
+/**
+ * @brief look up a strategy spec the lockstep engine can play
+ *
+ * @return err_t ERROR for strategies it can't (e.g. pipes)
+ */
+err_t lockstep_kind(const char* const spec, lockstep_kind_t* const into);
+
+/**
+ * @brief play games first .. first + games - 1 of a run
+ *
+ * @param seats the strategy in each seat, seat 0 moves first
+ * @param swap_odd swap the seats in odd numbered games
+ * @param results one per game, the same sim_play would give
+ */
+void lockstep_play(
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              first,
+    long                  games,
+    bool                  swap_odd,
+    sim_result_t* const   results);
+
+/**
+ * @brief play `games` games with sim_play and with the lockstep engine
+ * (scalar and AVX2), check they agree game for game and report the
+ * speedup
+ *
+ * @return int process exit code, 1 if any game differs
+ */
+int lockstep_bench(const char* const specs[2], long games, uint64_t seed);
+
+/**
+ * @brief what the engine keeps of a game between turns
+ */
+typedef struct {
+    card_mask_t hand[2];    // by seat
+    uint16_t    booked[2];  // rank slots booked, by seat
+    uint8_t     remaining;  // cards left in the deck
+    uint8_t     to_move;    // the seat whose turn is next
+} lockstep_state_t;
+
+typedef struct lockstep_game lockstep_game_t;
+
+/**
+ * @brief one game on the engine, played a turn at a time from outside
+ * (the differential fuzzer, see fuzz.h) rather than by its strategies
+ *
+ * @param dealt the deck, RULES_HAND each are dealt off it like sim_play
+ * @param vector resolve asks with the AVX2 code if the CPU has it,
+ * rather than the scalar code
+ */
+lockstep_game_t* lockstep_game_start(
+    const deck_t* const dealt,
+    bool                vector);
+
+/**
+ * @brief play the mover's turn, drawing up first like play_turn
+ *
+ * @param pick the rank slot to ask for, given the mover's hand, not
+ * called if the turn is passed
+ */
+turn_result_t lockstep_game_turn(
+    lockstep_game_t* const game,
+    int (*pick)(card_mask_t held, void* ctx),
+    void* ctx);
+
+lockstep_state_t lockstep_game_state(const lockstep_game_t* const game);
+
+void lockstep_game_end(lockstep_game_t* const game);
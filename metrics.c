@@ -0,0 +1,479 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <poll.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#include "metrics.h"
+#include "serve.h"
+
+struct metrics {
+    metrics_counters_t* counters;  // one per worker
+    int                 threads;
+    const char*         addr;
+    const char*         specs[2];
+    long                planned, resumed;
+    double              start;
+    int                 lfd;
+    _Atomic bool        stop;
+    pthread_t           tid;
+};
+
+static const int turn_bounds[] = METRICS_TURN_BOUNDS;
+static const int streak_bounds[] = METRICS_STREAK_BOUNDS;
+
+static uint64_t bump(_Atomic uint64_t* const counter, uint64_t by) {
+    return atomic_fetch_add_explicit(counter, by, memory_order_relaxed);
+}
+
+static uint64_t peek(_Atomic uint64_t* const counter) {
+    return atomic_load_explicit(counter, memory_order_relaxed);
+}
+
+// the bucket a value falls in, `count` is the +Inf bucket
+static int bucket(const int* bounds, int count, int value) {
+    int idx = 0;
+    while (idx < count && value > bounds[idx]) idx++;
+    return idx;
+}
+
+void metrics_add(
+    metrics_counters_t* const counters,
+    const stats_t* const      chunk  //
+) {
+    bump(&counters->games, chunk->games);
+    bump(&counters->seat0_wins, chunk->seat0_wins);
+    bump(&counters->wins[0], chunk->wins[0]);
+    bump(&counters->wins[1], chunk->wins[1]);
+
+    // fold the chunk's exact histograms down to the buckets first, so
+    // it's one atomic add per bucket rather than per value
+    uint64_t turns[METRICS_TURN_BUCKETS + 1] = {0}, turns_sum = 0;
+    for (range(value, 0, STATS_TURNS + 1, 1)) {
+        uint64_t games = chunk->turns[value];
+        turns[bucket(turn_bounds, METRICS_TURN_BUCKETS, value)] += games;
+        turns_sum += games * value;
+    }
+    uint64_t streak[METRICS_STREAK_BUCKETS + 1] = {0}, streak_sum = 0;
+    for (range(value, 0, STATS_STREAK + 1, 1)) {
+        uint64_t games = chunk->streak[value];
+        streak[bucket(streak_bounds, METRICS_STREAK_BUCKETS, value)] +=
+            games;
+        streak_sum += games * value;
+    }
+
+    for (range(idx, 0, METRICS_TURN_BUCKETS + 1, 1))
+        if (turns[idx] != 0) bump(&counters->turns[idx], turns[idx]);
+    for (range(idx, 0, METRICS_STREAK_BUCKETS + 1, 1))
+        if (streak[idx] != 0) bump(&counters->streak[idx], streak[idx]);
+    bump(&counters->turns_sum, turns_sum);
+    bump(&counters->streak_sum, streak_sum);
+}
+
+metrics_counters_t* metrics_counters(metrics_t* const metrics, int idx) {
+    if (idx < 0 || idx >= metrics->threads)
+        ohcrap("no metrics counters for that worker");
+    return &metrics->counters[idx];
+}
+
+/* === [ the page ] === */
+
+// a label value with \, " and newlines escaped, as the format wants
+static void print_label(FILE* const out, const char* str) {
+    for (; *str != '\0'; str++) {
+        if (*str == '\\' || *str == '"')
+            fprintf(out, "\\%c", *str);
+        else if (*str == '\n')
+            fputs("\\n", out);
+        else
+            fputc(*str, out);
+    }
+}
+
+static void print_histogram(
+    FILE* const       out,
+    const char* const name,
+    const char* const help,
+    const int*        bounds,
+    int               count,
+    const uint64_t*   buckets,
+    uint64_t          sum,
+    uint64_t          games  //
+) {
+    fprintf(out, "# HELP %s %s\n# TYPE %s histogram\n", name, help, name);
+    uint64_t below = 0;
+    for (range(idx, 0, count, 1)) {
+        below += buckets[idx];
+        fprintf(
+            out,
+            "%s_bucket{le=\"%i\"} %llu\n",
+            name,
+            bounds[idx],
+            (unsigned long long)below);
+    }
+    fprintf(
+        out,
+        "%s_bucket{le=\"+Inf\"} %llu\n%s_sum %llu\n%s_count %llu\n",
+        name,
+        (unsigned long long)games,
+        name,
+        (unsigned long long)sum,
+        name,
+        (unsigned long long)games);
+}
+
+// sum every worker's counters and write them out, returns the length
+static size_t render(metrics_t* const metrics, char* page, size_t size) {
+    uint64_t games = 0, seat0 = 0, wins[2] = {0}, turns_sum = 0;
+    uint64_t streak_sum = 0;
+    uint64_t turns[METRICS_TURN_BUCKETS + 1] = {0};
+    uint64_t streak[METRICS_STREAK_BUCKETS + 1] = {0};
+    for (range(idx, 0, metrics->threads, 1)) {
+        metrics_counters_t* counters = &metrics->counters[idx];
+        games += peek(&counters->games);
+        seat0 += peek(&counters->seat0_wins);
+        wins[0] += peek(&counters->wins[0]);
+        wins[1] += peek(&counters->wins[1]);
+        turns_sum += peek(&counters->turns_sum);
+        streak_sum += peek(&counters->streak_sum);
+        for (range(b, 0, METRICS_TURN_BUCKETS + 1, 1))
+            turns[b] += peek(&counters->turns[b]);
+        for (range(b, 0, METRICS_STREAK_BUCKETS + 1, 1))
+            streak[b] += peek(&counters->streak[b]);
+    }
+    double elapsed = sim_now() - metrics->start;
+
+    FILE* out = fmemopen(page, size, "w");
+    if (out == NULL) return 0;
+    fprintf(
+        out,
+        "# HELP gofish_games_total Games played by this process.\n"
+        "# TYPE gofish_games_total counter\n"
+        "gofish_games_total %llu\n"
+        "# HELP gofish_games_planned Games this process will play.\n"
+        "# TYPE gofish_games_planned gauge\n"
+        "gofish_games_planned %li\n"
+        "# HELP gofish_games_resumed Games counted before a resume.\n"
+        "# TYPE gofish_games_resumed gauge\n"
+        "gofish_games_resumed %li\n"
+        "# HELP gofish_games_per_second Games played per second so far.\n"
+        "# TYPE gofish_games_per_second gauge\n"
+        "gofish_games_per_second %.1f\n"
+        "# HELP gofish_elapsed_seconds Time since the run started.\n"
+        "# TYPE gofish_elapsed_seconds gauge\n"
+        "gofish_elapsed_seconds %.3f\n"
+        "# HELP gofish_threads Worker threads.\n"
+        "# TYPE gofish_threads gauge\n"
+        "gofish_threads %i\n",
+        (unsigned long long)games,
+        metrics->planned,
+        metrics->resumed,
+        elapsed > 0 ? games / elapsed : 0,
+        elapsed,
+        metrics->threads);
+
+    fputs(
+        "# HELP gofish_wins_total Games won, by strategy.\n"
+        "# TYPE gofish_wins_total counter\n",
+        out);
+    for (range(idx, 0, 2, 1)) {
+        fprintf(out, "gofish_wins_total{strategy=\"%c\",spec=\"", 'A' + idx);
+        print_label(out, metrics->specs[idx]);
+        fprintf(out, "\"} %llu\n", (unsigned long long)wins[idx]);
+    }
+    fprintf(
+        out,
+        "# HELP gofish_seat0_wins_total Games won by whoever moved first.\n"
+        "# TYPE gofish_seat0_wins_total counter\n"
+        "gofish_seat0_wins_total %llu\n",
+        (unsigned long long)seat0);
+
+    print_histogram(
+        out,
+        "gofish_turns",
+        "Turns a game took.",
+        turn_bounds,
+        METRICS_TURN_BUCKETS,
+        turns,
+        turns_sum,
+        games);
+    print_histogram(
+        out,
+        "gofish_streak",
+        "The most extra turns in a row in a game.",
+        streak_bounds,
+        METRICS_STREAK_BUCKETS,
+        streak,
+        streak_sum,
+        games);
+
+    long length = ftell(out);
+    fclose(out);
+    return length > 0 && (size_t)length < size ? (size_t)length : 0;
+}
+
+/* === [ server ] === */
+
+static void send_all(int fd, const char* data, size_t left) {
+    while (left > 0) {
+        ssize_t sent = send(fd, data, left, MSG_NOSIGNAL);
+        if (sent < 0 && errno == EINTR) continue;
+        if (sent <= 0) return;
+        data += sent;
+        left -= sent;
+    }
+}
+
+// any request gets the page, the request itself is read and ignored
+static void answer(metrics_t* const metrics, int fd) {
+    char request[1024];
+    if (poll(&(struct pollfd){.fd = fd, .events = POLLIN}, 1, 100) > 0)
+        (void)!read(fd, request, sizeof(request));
+
+    static char page[METRICS_PAGE_BYTES];
+    size_t      length = render(metrics, page, sizeof(page));
+
+    char head[160];
+    int  head_length = snprintf(
+        head,
+        sizeof(head),
+        "HTTP/1.0 200 OK\r\n"
+        "Content-Type: text/plain; version=0.0.4\r\n"
+        "Content-Length: %zu\r\n"
+        "Connection: close\r\n\r\n",
+        length);
+    send_all(fd, head, head_length);
+    send_all(fd, page, length);
+}
+
+static void* serve_metrics(void* arg) {
+    metrics_t* metrics = arg;
+    while (!atomic_load(&metrics->stop)) {
+        struct pollfd listening = {.fd = metrics->lfd, .events = POLLIN};
+        if (poll(&listening, 1, METRICS_POLL_MS) <= 0) continue;
+
+        int fd = accept(metrics->lfd, NULL, NULL);
+        if (fd < 0) continue;
+        answer(metrics, fd);
+        close(fd);
+    }
+    return NULL;
+}
+
+metrics_t* metrics_start(
+    const char* const addr,
+    int               threads,
+    const char* const specs[2],
+    long              planned,
+    long              resumed  //
+) {
+    metrics_t* metrics = calloc(1, sizeof(metrics_t));
+    metrics->counters = aligned_alloc(
+        _Alignof(metrics_counters_t),
+        threads * sizeof(metrics_counters_t));
+    if (metrics->counters == NULL) ohcrap("out of memory");
+    memset(metrics->counters, 0, threads * sizeof(metrics_counters_t));
+
+    metrics->threads = threads;
+    metrics->addr = addr;
+    metrics->specs[0] = specs[0];
+    metrics->specs[1] = specs[1];
+    metrics->planned = planned;
+    metrics->resumed = resumed;
+    metrics->start = sim_now();
+    metrics->lfd = serve_listen(addr);
+    atomic_init(&metrics->stop, false);
+    pthread_create(&metrics->tid, NULL, &serve_metrics, metrics);
+    return metrics;
+}
+
+void metrics_stop(metrics_t* const metrics) {
+    atomic_store(&metrics->stop, true);
+    pthread_join(metrics->tid, NULL);
+    close(metrics->lfd);
+    if (strncmp(metrics->addr, "unix:", 5) == 0) unlink(&metrics->addr[5]);
+    free(metrics->counters);
+    free(metrics);
+}
+
+/* === [ dashboard ] === */
+
+typedef struct {
+    double games, planned, resumed, rate, elapsed, threads, seat0;
+    double wins[2], turns_sum;
+    char   specs[2][64];
+    // cumulative, as scraped
+    double turns[METRICS_TURN_BUCKETS + 1];
+} scrape_t;
+
+// fetch the page, false once nothing answers
+static bool scrape(const char* const addr, char* page, size_t size) {
+    int fd = serve_dial(addr);
+    if (fd < 0) return false;
+
+    const char request[] = "GET /metrics HTTP/1.0\r\n\r\n";
+    send_all(fd, request, sizeof(request) - 1);
+
+    size_t length = 0;
+    for (;;) {
+        ssize_t got = read(fd, &page[length], size - 1 - length);
+        if (got < 0 && errno == EINTR) continue;
+        if (got <= 0) break;
+        length += got;
+    }
+    close(fd);
+    page[length] = '\0';
+    return length > 0;
+}
+
+// the spec label of a wins line, unescaped
+static void read_spec(const char* line, char* into, size_t size) {
+    const char* from = strstr(line, "spec=\"");
+    size_t      len = 0;
+    if (from != NULL) {
+        for (from += 6; *from != '\0' && *from != '"'; from++) {
+            char c = *from;
+            if (c == '\\' && from[1] != '\0')
+                c = *++from == 'n' ? '\n' : *from;
+            if (len + 1 < size) into[len++] = c;
+        }
+    }
+    into[len] = '\0';
+}
+
+static void parse_page(char* page, scrape_t* const into) {
+    memset(into, 0, sizeof(*into));
+
+    // skip the headers
+    char* body = strstr(page, "\r\n\r\n");
+    body = body != NULL ? body + 4 : page;
+
+    int wins = 0, turns = 0;
+    for (char* line = strtok(body, "\n"); line != NULL;
+         line = strtok(NULL, "\n")) {
+        if (line[0] == '#') continue;
+        char*  space = strrchr(line, ' ');
+        double value = space != NULL ? atof(space + 1) : 0;
+
+        struct {
+            const char* name;
+            double*     into;
+        } plain[] = {
+            {"gofish_games_total ", &into->games},
+            {"gofish_games_planned ", &into->planned},
+            {"gofish_games_resumed ", &into->resumed},
+            {"gofish_games_per_second ", &into->rate},
+            {"gofish_elapsed_seconds ", &into->elapsed},
+            {"gofish_threads ", &into->threads},
+            {"gofish_seat0_wins_total ", &into->seat0},
+            {"gofish_turns_sum ", &into->turns_sum},
+        };
+        for (range(idx, 0, sizeof(plain) / sizeof(plain[0]), 1))
+            if (strncmp(line, plain[idx].name, strlen(plain[idx].name)) ==
+                0)
+                *plain[idx].into = value;
+
+        // labelled lines come in the order they're written
+        if (strncmp(line, "gofish_wins_total{", 18) == 0 && wins < 2) {
+            read_spec(line, into->specs[wins], sizeof(into->specs[0]));
+            into->wins[wins++] = value;
+        }
+        if (strncmp(line, "gofish_turns_bucket{", 20) == 0 &&
+            turns <= METRICS_TURN_BUCKETS)
+            into->turns[turns++] = value;
+    }
+}
+
+static void print_dashboard(const char* const addr, const scrape_t* s) {
+    double left = s->planned - s->games;
+    double eta = s->rate > 0 ? left / s->rate : 0;
+    double done = s->planned > 0 ? 100 * s->games / s->planned : 0;
+
+    printf(
+        "gofish run at %s, %.0f threads, %.0fs in\n\n"
+        "  games    %.0f of %.0f (%.1f%%)",
+        addr,
+        s->threads,
+        s->elapsed,
+        s->games,
+        s->planned,
+        done);
+    if (s->resumed > 0) printf(", +%.0f resumed", s->resumed);
+    printf("\n  speed    %.0f games/sec", s->rate);
+    if (left > 0 && s->rate > 0)
+        printf(
+            ", done in %im%02is", (int)eta / 60, (int)eta % 60);
+    printf("\n\n");
+
+    if (s->games <= 0) return;
+    for (range(idx, 0, 2, 1))
+        printf(
+            "  %c %-20s won %6.2f%%\n",
+            'A' + idx,
+            s->specs[idx],
+            100 * s->wins[idx] / s->games);
+    printf("  seat 0 won %.2f%%\n\n", 100 * s->seat0 / s->games);
+
+    // the median is only known to a bucket
+    int    median = 0;
+    double half = s->games / 2;
+    while (median < METRICS_TURN_BUCKETS && s->turns[median] < half)
+        median++;
+    static const int bounds[] = METRICS_TURN_BOUNDS;
+    printf("  turns    mean %.1f, median ", s->turns_sum / s->games);
+    if (median < METRICS_TURN_BUCKETS)
+        printf("%i or less\n", bounds[median]);
+    else
+        printf("over %i\n", bounds[METRICS_TURN_BUCKETS - 1]);
+}
+
+int metrics_dashboard(const char* const addr) {
+    static char page[METRICS_PAGE_BYTES];
+    bool        tty = isatty(STDOUT_FILENO);
+    bool        seen = false;
+    scrape_t    last;
+
+    while (scrape(addr, page, sizeof(page))) {
+        parse_page(page, &last);
+        seen = true;
+        if (tty) printf("\033[H\033[2J");
+        print_dashboard(addr, &last);
+        if (!tty) printf("\n");
+        fflush(stdout);
+        sleep(1);
+    }
+
+    if (!seen) {
+        fprintf(stderr, "nothing is serving metrics at %s\n", addr);
+        return 1;
+    }
+    printf("\nthe run has finished\n");
+    return 0;
+}
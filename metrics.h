@@ -0,0 +1,106 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "stats.h"
+
+/** === [ Live metrics ] ===
+ *
+ * A running --simulate can serve its progress (--metrics <addr>, the
+ * same unix:<path> / tcp:<port> addresses as --serve) as a one page
+ * HTTP endpoint in the Prometheus text format, so any scraper (or
+ * `curl --unix-socket`) can watch it, and `--stats <addr>` turns it
+ * into a dashboard in the terminal.
+ *
+ * Every worker thread has its own cache line aligned set of counters
+ * that only it writes, bumped with relaxed atomic adds once per chunk
+ * of games from the chunk's stats_t, so the game loop never takes a
+ * lock or shares a cache line. A scrape sums the counters of every
+ * thread; each one is exact as of some recent chunk, so a scrape is a
+ * little behind, never wrong.
+ *
+ *   gofish_games_total, gofish_games_planned, gofish_games_resumed
+ *   gofish_games_per_second, gofish_elapsed_seconds
+ *   gofish_wins_total{strategy}, gofish_seat0_wins_total
+ *   gofish_turns (histogram), gofish_streak (histogram)
+ */
+
+#define METRICS_TURN_BUCKETS   10
+#define METRICS_STREAK_BUCKETS 8
+#define METRICS_PAGE_BYTES     16384  // the whole response, at most
+#define METRICS_POLL_MS        200    // how often the server checks to stop
+
+// the upper bounds of each histogram's buckets, then +Inf
+#define METRICS_TURN_BOUNDS   {30, 40, 45, 50, 55, 60, 70, 80, 100, 150}
+#define METRICS_STREAK_BOUNDS {1, 2, 3, 4, 6, 8, 12, 16}
+
+/**
+ * @brief one worker's counters, written only by that worker
+ */
+typedef struct {
+    _Atomic uint64_t games, seat0_wins, wins[2], turns_sum, streak_sum;
+    // per bucket, not yet cumulative
+    _Atomic uint64_t turns[METRICS_TURN_BUCKETS + 1];
+    _Atomic uint64_t streak[METRICS_STREAK_BUCKETS + 1];
+} __attribute__((aligned(64))) metrics_counters_t;
+
+typedef struct metrics metrics_t;
+
+/**
+ * @brief start serving a run's metrics on `addr` from a thread of its
+ * own
+ *
+ * @param threads workers that will have counters
+ * @param planned games this process will play
+ * @param resumed games already counted in a checkpoint it resumed
+ */
+metrics_t* metrics_start(
+    const char* const addr,
+    int               threads,
+    const char* const specs[2],
+    long              planned,
+    long              resumed);
+
+/**
+ * @brief worker `idx`'s counters
+ */
+metrics_counters_t* metrics_counters(metrics_t* const, int idx);
+
+/**
+ * @brief count a finished chunk of games, from the worker that played
+ * them
+ */
+void metrics_add(metrics_counters_t* const, const stats_t* const chunk);
+
+/**
+ * @brief stop serving and free everything
+ */
+void metrics_stop(metrics_t* const);
+
+/**
+ * @brief `--stats <addr>`, redraw a dashboard of a run's metrics every
+ * second until the run ends
+ *
+ * @return int process exit code
+ */
+int metrics_dashboard(const char* const addr);
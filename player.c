@@ -27,8 +27,12 @@
 #include <stdint.h>
 #include <time.h>
 #include <ctype.h>
+#include <stdatomic.h>
 
 #include "player.h"
+#include "endgame.h"
+#include "frame.h"
+#include "check.h"
 
 void __attribute__((noreturn)) ohcrap(const char *const msg) {
     fprintf(stderr, "\nError: %s\n", msg);
@@ -42,10 +46,13 @@ player_t player_init(
 ) {
     // base setup
     player_t p = {
-        .hand = (hand_t){.head = NULL, .length = 0},
+        .hand = (hand_t){.head = NULL, .tail = NULL, .length = 0},
         .name = name,
         .reveal_cards = reveal_cards,
         .read_rank = read_rank,
+        .ctx = NULL,
+        .opponent = NULL,
+        .deck = NULL,
         .books =
             {RANK_NULL,
              RANK_NULL,
@@ -58,10 +65,26 @@ player_t player_init(
     // set the overflow member to 0 as an always present null
     // terminator / canary
     p._canary = 0;
+    belief_reset(&p.seen);
+
+    // the count keeps players made within the same second apart
+    static _Atomic uint64_t made = 0;
+    rng_seed(&p.rng, rng_mix(time(NULL), made++));
 
     return p;
 }
 
+void player_seat(
+    player_t *const a,
+    player_t *const b,
+    const deck_t   *deck  //
+) {
+    a->opponent = b;
+    b->opponent = a;
+    a->deck = deck;
+    b->deck = deck;
+}
+
 void player_cleanup(player_t *player) {
     // free each hand node
     hand_node_t node = player->hand.head;
@@ -75,7 +98,7 @@ void player_cleanup(player_t *player) {
 
     // check for leak or ~~daemons eating your socks due to undefined
     // behavior~~... i mean double-free
-    if (node_count != player->hand.length) {
+    if (check_due() && node_count != player->hand.length) {
         char *errmsg;
         asprintf(
             &errmsg,
@@ -87,44 +110,22 @@ void player_cleanup(player_t *player) {
     }
 
     // then clear out the hand
-    player->hand = (hand_t){.head = NULL, .length = 0};
+    player->hand = (hand_t){.head = NULL, .tail = NULL, .length = 0};
 }
 
 void player_print_hand(const player_t *const player) {
-    printf("%s's hand – ", player->name);
-    // printf(" {%u} ", player->hand.length);
-
-    hand_node_t node = player->hand.head;
-    while (node != NULL) {
-        card_pretty_str_t buf;
-        card_sfmt(node->card, &buf);
-        printf("%s ", buf.str);
-        node = node->next;
-    }
-    printf("\n");
+    if (game_out != NULL) fputs(frame_hand(player), game_out);
 }
 
 void player_print_books(const player_t *const player) {
-    printf("%s's books – ", player->name);
-
-    bool prev_was_blank = false;
-    for (range(idx, 0, 7, 1)) {
-        // check: if the book was previously terminated the rest
-        // should be RANK_NULLS too
-        if (prev_was_blank && player->books[idx] != RANK_NULL)
-            ohcrap("invalid book, incorrectly terminated");
-
-        // otherwise, print
-        rank_t book = player->books[idx];
-        if (book != RANK_NULL) printf("%-2s ", rank_as_str(book));
-    }
-    printf("\n");
+    if (game_out != NULL) fputs(frame_books(player), game_out);
 }
 
 bool player_user_wants_to_play_again() {
     for (;;) {
         // ask
-        printf("Do you want to play again [Y/N]: " ESC_RED);
+        game_printf("Do you want to play again [Y/N]: " ESC_RED);
+        frame_flush();
         char str[7];
         if (fgets(str, 4, stdin) == NULL)
             ohcrap(ESC_RST " fgets failed, something's serisouly wrong");
@@ -135,7 +136,7 @@ bool player_user_wants_to_play_again() {
                 break;
             }
         }
-        printf(ESC_RST);  // always turn red off
+        game_printf(ESC_RST);  // always turn red off
 
         // parse
         switch (toupper(rank_input)) {
@@ -144,21 +145,22 @@ bool player_user_wants_to_play_again() {
             case 'N':
                 return false;
             default:
-                printf("Invalid input\n");
+                game_printf("Invalid input\n");
         };
     };
 }
 
 rank_t player_query_for_rank(player_t *player) {
     for (;;) {
-        printf("What are you looking for? enter a Rank: " ESC_RED);
+        game_printf("What are you looking for? enter a Rank: " ESC_RED);
+        frame_flush();
 
         // query for the rank
         char str[7] = {0};
         if (fgets(str, 5, stdin) == NULL)
             ohcrap(ESC_RST " fgets failed, something's serisouly wrong");
 
-        printf(ESC_RST);
+        game_printf(ESC_RST);
 
         // to pass this to rank_from_str, write a null terminator
         // in any '\n' char
@@ -174,31 +176,38 @@ rank_t player_query_for_rank(player_t *player) {
         }
 
         // otherwise warn and repeat
-        printf("Invalid choice '%s', enter a valid rank you have\n", str);
+        game_printf(
+            "Invalid choice '%s', enter a valid rank you have\n", str);
     }
 }
 
 rank_t play_compy_turn(player_t *player) {
-    // randomly select a card's index and we'll return it's rank
-    srand(time(NULL));
-    int idx = rand() % player->hand.length;
+    // once the deck is out everything is known, so play it perfectly
+    if (player->deck != NULL && player->deck->remaining == 0 &&
+        player->hand.length != 0) {
+        rank_t rank = endgame_solve(endgame_key_for(player)).best;
+        game_printf(
+            "%s is looking for Rank: " ESC_CYN "%s" ESC_RST "\n",
+            player->name,
+            rank_as_str(rank));
+        return rank;
+    }
 
     // if the hand is empty, error and return
     if (player->hand.length == 0) return RANK_NULL;
 
-    // go borrow the card, the hand still maintains ownership
-    hand_node_t node = player->hand.head;
-    for (range(_, 0, idx, 1)) {
-        if (node->next == NULL)
-            ohcrap(
-                "cannot select a card past the end of the  copmy's "
-                "hand ().");
-        node = node->next;
-    }
+    // randomly select a card and we'll return it's rank, counting the
+    // cards in index order (not the hand's) so the choice only depends
+    // on which cards are held, see lockstep.h
+    int         idx = rng_below(&player->rng, player->hand.length);
+    card_mask_t held = hand_mask(&player->hand);
+    if (check_due() &&
+        __builtin_popcountll(held) != (int)player->hand.length)
+        ohcrap("the copmy's hand has a card in it twice");
 
-    rank_t rank = node->card.rank;
+    rank_t rank = card_idx_rank(card_mask_nth(held, idx));
 
-    printf(
+    game_printf(
         "%s is looking for Rank: " ESC_CYN "%s" ESC_RST "\n",
         player->name,
         rank_as_str(rank));
@@ -207,16 +216,31 @@ rank_t play_compy_turn(player_t *player) {
     return rank;
 }
 
+rank_t play_compy_belief_turn(player_t *player) {
+    rank_t rank;
+    if (player->deck != NULL && player->deck->remaining == 0 &&
+        player->hand.length != 0)
+        rank = endgame_solve(endgame_key_for(player)).best;
+    else
+        rank = belief_best_ask(player);
+
+    game_printf(
+        "%s is looking for Rank: " ESC_CYN "%s" ESC_RST "\n",
+        player->name,
+        rank_as_str(rank));
+    return rank;
+}
+
 void player_deal_cards(
     player_t *const player,
     deck_t *const   deck,
     uint8_t         count  //
 ) {
     for (range(_, 0, count, 1)) {
-        card_t card = CARD_NULL;
+        card_idx_t card = CARD_IDX_NULL;
 
-        if (deck_deal(deck, &card))
-            hand_add_card(&player->hand, card);
+        if (deck_deal_idx(deck, &card))
+            hand_add_card_idx(&player->hand, card);
         else
             ohcrap("cannot deal from an empty deck");
     };
@@ -224,17 +248,26 @@ void player_deal_cards(
 
 bool player_add_book_did_win(player_t *const player, rank_t rank) {
     rank_t *books = player->books;
-    for (range(idx, 0, 7, 1))
+    for (range(idx, 0, RULES_TO_WIN, 1))
         if (books[idx] == RANK_NULL) {
             books[idx] = rank;
-            bool did_win = idx == 6;
+            bool did_win = idx == RULES_TO_WIN - 1;
             if (did_win) {  // true when this last the last indexs
                 player_print_books(player);
-                printf(
+                game_printf(
                     "\n\nHear ye! Hear ye! %s has won!\n\n", player->name);
                 return true;
             }
             return did_win;
         }
     return false;
+}
+
+uint16_t player_booked_slots(const player_t *const player) {
+    uint16_t slots = 0;
+    for (range(idx, 0, RULES_TO_WIN, 1)) {
+        if (player->books[idx] == RANK_NULL) break;
+        slots |= 1 << (player->books[idx] - RANK_2);
+    }
+    return slots;
 }
\ No newline at end of file
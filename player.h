@@ -26,6 +26,8 @@
 
 // #include "card.h"
 #include "deck.h"
+#include "belief.h"
+#include "rules.h"
 
 // /* === [ start template compat ] === */
 // int add_card(struct player* target, struct card* new_card);
@@ -50,11 +52,23 @@ typedef struct _player {
     rank_t (*const read_rank)(struct _player*);
     // whether to print the player's hand
     const bool reveal_cards;
+    // state owned by whatever backs read_rank (a server table, etc),
+    // nullable and left alone by the game itself
+    void* ctx;
+    // what the player can see of the table, set by player_seat
+    const struct _player* opponent;  // nullable
+    const deck_t*         deck;      // nullable
     /* --- mutated --- */
+    // the player's own random stream (for read_rank callbacks that need
+    // one), seeded by player_init and re-seeded for replayable games
+    rng_t rng;
     // the player's hand
     hand_t hand;
+    // what the table has seen of the hand, for the opponent to reason
+    // with, updated by play_turn
+    belief_t seen;
     // the ranks that player has collected, null terminated
-    rank_t books[7];
+    rank_t books[RULES_TO_WIN];
     // overflow / canary padding
     rank_t _canary;
 } player_t;
@@ -71,6 +85,12 @@ player_t player_init(
     bool              reveal_cards,
     rank_t (*read_rank)(struct _player*));
 
+/**
+ * @brief sit two players at a table, giving each a view of the other
+ * and the deck (what read_rank callbacks can use to decide)
+ */
+void player_seat(player_t* const a, player_t* const b, const deck_t* deck);
+
 // TODO docstring
 void player_cleanup(player_t* const);
 
@@ -120,6 +140,12 @@ rank_t player_query_for_rank(player_t* player);
 // TODO docstring
 rank_t play_compy_turn(player_t* player);
 
+/**
+ * @brief the computer player asking for the rank its opponent most
+ * likely holds, going by what it has seen so far (see belief.h)
+ */
+rank_t play_compy_belief_turn(player_t* player);
+
 /**
  * @brief adds a rank to a player's book
  *
@@ -127,4 +153,11 @@ rank_t play_compy_turn(player_t* player);
  *
  * @return true if the player won, else false
  */
-bool player_add_book_did_win(player_t* const, rank_t);
\ No newline at end of file
+bool player_add_book_did_win(player_t* const, rank_t);
+
+/**
+ * @brief the rank slots a player has booked, bit r for rank RANK_2 + r
+ *
+ * reads up to the first RANK_NULL, check_books is what validates them.
+ */
+uint16_t player_booked_slots(const player_t* const);
\ No newline at end of file
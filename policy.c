@@ -0,0 +1,398 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <assert.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "policy.h"
+#include "sim.h"
+#include "endgame.h"
+
+#define POLICY_MAGIC   "GOFISHPT"
+#define POLICY_VERSION 1
+#define POLICY_ASKS    512  // asks one player makes in a game, at most
+
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t states;
+} header_t;
+
+// what the opponent is seen to have of a rank, see belief.h
+enum {
+    SEEN_SOME,
+    SEEN_NONE,  // none as of a draw or less ago
+    SEEN_UNKNOWN,
+};
+
+/**
+ * the state of a player about to ask, and the class of each rank slot
+ * (POLICY_UNSET for the ones not in its hand)
+ */
+static int policy_state(
+    const player_t* const player,
+    uint8_t               class_of[13]  //
+) {
+    const belief_t* seen = &player->opponent->seen;
+    card_mask_t     mine = hand_mask(&player->hand);
+    int             in_class[POLICY_CLASSES] = {0};
+
+    for (range(slot, 0, 13, 1)) {
+        card_mask_t rank = card_mask_rank(slot);
+        int         held = __builtin_popcountll(mine & rank);
+        class_of[slot] = POLICY_UNSET;
+        if (held == 0) continue;
+        // a dealt four of a kind stays in hand until an ask or a draw
+        // books it, and asks the same as three
+        if (held > 3) held = 3;
+
+        int status = SEEN_UNKNOWN;
+        if ((seen->known & rank) || (seen->asked >> slot & 1))
+            status = SEEN_SOME;
+        else if ((seen->draws >> 4 * slot & BELIEF_NO_INFO) <= 1)
+            status = SEEN_NONE;
+        class_of[slot] = (held - 1) * 3 + status;
+        assert(class_of[slot] < POLICY_CLASSES);
+        in_class[class_of[slot]]++;
+    }
+
+    // the deck has 1 to 38 cards before the endgame
+    int state = (player->deck->remaining - 1) / 10;
+    if (state >= POLICY_BUCKETS) state = POLICY_BUCKETS - 1;
+    for (range(class, 0, POLICY_CLASSES, 1))
+        state = state * 3 + (in_class[class] < 2 ? in_class[class] : 2);
+    assert(state < POLICY_STATES);
+    return state;
+}
+
+// a hand dealt all four of a rank has to land in a class and a state
+// the tables have room for, checked before training fills one
+static void check_four_held() {
+    deck_t   deck = {0};
+    player_t me = player_init("four", false, &play_compy_belief_turn);
+    player_t other = player_init("other", false, &play_compy_belief_turn);
+    deck_init(&deck);
+    player_seat(&me, &other, &deck);
+    // all four twos, three threes
+    for (range(suit, 0, 4, 1)) hand_add_card_idx(&me.hand, suit * 13);
+    for (range(suit, 0, 3, 1)) hand_add_card_idx(&me.hand, suit * 13 + 1);
+
+    uint8_t class_of[13];
+    int     state = policy_state(&me, class_of);
+    if (state < 0 || state >= POLICY_STATES ||
+        class_of[0] >= POLICY_CLASSES || class_of[0] != class_of[1])
+        ohcrap("four of a kind in hand falls outside the policy table");
+
+    player_cleanup(&me);
+    player_cleanup(&other);
+}
+
+/**
+ * the rank to ask, going by `actions` (nullable) with `explore` % of
+ * asks made from a random class instead, and the state and class it
+ * was asked from (state -1 for endgame moves, which are solved)
+ */
+static rank_t choose(
+    player_t* const      player,
+    const uint8_t* const actions,
+    int                  explore,
+    int* const           state_out,
+    int* const           class_out  //
+) {
+    *state_out = -1;
+    if (player->hand.length == 0 || player->opponent == NULL ||
+        player->deck == NULL)
+        return belief_best_ask(player);
+    if (player->deck->remaining == 0)
+        return endgame_solve(endgame_key_for(player)).best;
+
+    uint8_t class_of[13];
+    int     state = policy_state(player, class_of);
+    int     action = actions != NULL ? actions[state] : POLICY_UNSET;
+
+    if (explore > 0 && (int)rng_below(&player->rng, 100) < explore) {
+        // a uniformly random class of the ones in hand
+        int present[POLICY_CLASSES], count = 0;
+        for (range(class, 0, POLICY_CLASSES, 1))
+            for (range(slot, 0, 13, 1))
+                if (class_of[slot] == class) {
+                    present[count++] = class;
+                    break;
+                }
+        action = present[rng_below(&player->rng, count)];
+    }
+
+    rank_t rank = RANK_NULL;
+    for (range(slot, 0, 13, 1))
+        if (action != POLICY_UNSET && class_of[slot] == action) {
+            rank = slot + RANK_2;
+            break;
+        }
+    // unset (or a table from some other abstraction)
+    if (rank == RANK_NULL) rank = belief_best_ask(player);
+
+    *state_out = state;
+    *class_out = class_of[rank - RANK_2];
+    return rank;
+}
+
+policy_t* policy_open(const char* const path) {
+    int fd = open(path, O_RDONLY);
+    if (fd < 0) ohcrap("unable to open the policy table");
+
+    struct stat info;
+    if (fstat(fd, &info) != 0) ohcrap("unable to stat the policy table");
+    size_t size = info.st_size;
+    if (size != sizeof(header_t) + POLICY_STATES)
+        ohcrap("the policy table is the wrong size");
+
+    // shared between every thread and process using the table, and
+    // only paged in as states are looked up
+    void* map = mmap(NULL, size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (map == MAP_FAILED) ohcrap("unable to map the policy table");
+    madvise(map, size, MADV_RANDOM);
+
+    const header_t* header = map;
+    if (memcmp(header->magic, POLICY_MAGIC, sizeof(header->magic)) != 0 ||
+        header->version != POLICY_VERSION ||
+        header->states != POLICY_STATES)
+        ohcrap("not a policy table, or a different version");
+
+    policy_t* policy = malloc(sizeof(policy_t));
+    *policy = (policy_t){
+        .map = map,
+        .size = size,
+        .actions = (const uint8_t*)map + sizeof(header_t),
+    };
+    return policy;
+}
+
+void policy_close(policy_t* const policy) {
+    munmap(policy->map, policy->size);
+    free(policy);
+}
+
+rank_t policy_read_rank(player_t* player) {
+    const policy_t* policy = player->ctx;
+    int             state, class;
+    rank_t rank = choose(player, policy->actions, 0, &state, &class);
+    game_printf(
+        "%s is looking for Rank: " ESC_CYN "%s" ESC_RST "\n",
+        player->name,
+        rank_as_str(rank));
+    return rank;
+}
+
+/* === [ Training ] === */
+
+// tries and wins of each class in each state
+typedef struct {
+    uint32_t tries[POLICY_STATES][POLICY_CLASSES];
+    uint32_t wins[POLICY_STATES][POLICY_CLASSES];
+    long     games, won;
+} tally_t;
+
+// the player being trained, its ctx
+typedef struct {
+    const uint8_t* actions;
+    int            count;
+    struct {
+        int     state;
+        uint8_t class;
+    } asks[POLICY_ASKS];
+} trainee_t;
+
+typedef struct {
+    const char*    opponent;
+    uint64_t       seed;
+    const uint8_t* actions;  // the table as of the last round
+    _Atomic long   next_game;
+    long           end_game;
+} training_t;
+
+typedef struct {
+    training_t* train;
+    tally_t*    tally;
+} trainer_t;
+
+static rank_t trainee_read_rank(player_t* player) {
+    trainee_t* me = player->ctx;
+    int        state, class;
+    rank_t     rank =
+        choose(player, me->actions, POLICY_EXPLORE, &state, &class);
+    if (state >= 0 && me->count < POLICY_ASKS) {
+        me->asks[me->count].state = state;
+        me->asks[me->count].class = class;
+        me->count++;
+    }
+    return rank;
+}
+
+static const strategy_def_t trainee_def = {
+    .name = "trainee",
+    .read_rank = &trainee_read_rank,
+};
+
+static void* train_worker(void* arg) {
+    trainer_t*  trainer = arg;
+    training_t* train = trainer->train;
+    tally_t*    tally = trainer->tally;
+
+    strategy_t opponent;
+    if (!strategy_open(train->opponent, &opponent))
+        ohcrap("unknown strategy");
+    trainee_t  me = {.actions = train->actions};
+    strategy_t trainee = {.def = &trainee_def, .ctx = &me};
+
+    // the trainee moves first in even games
+    const strategy_t* seats[2][2] = {
+        {&trainee, &opponent},
+        {&opponent, &trainee},
+    };
+
+    for (;;) {
+        long game = atomic_fetch_add(&train->next_game, 1);
+        if (game >= train->end_game) break;
+
+        me.count = 0;
+        sim_result_t result = sim_play(seats[game & 1], train->seed, game);
+        bool         won = result.winner == (game & 1);
+        for (range(idx, 0, me.count, 1)) {
+            tally->tries[me.asks[idx].state][me.asks[idx].class]++;
+            tally->wins[me.asks[idx].state][me.asks[idx].class] += won;
+        }
+        tally->games++;
+        tally->won += won;
+    }
+
+    strategy_close(&opponent);
+    endgame_release();
+    return NULL;
+}
+
+// each state's best class, of the ones tried enough
+static int settle(const tally_t* const total, uint8_t* const actions) {
+    int settled = 0;
+    for (range(state, 0, POLICY_STATES, 1)) {
+        double best_rate = -1;
+        actions[state] = POLICY_UNSET;
+        for (range(class, 0, POLICY_CLASSES, 1)) {
+            uint32_t tries = total->tries[state][class];
+            if (tries < POLICY_MIN_TRIES) continue;
+            double rate = (double)total->wins[state][class] / tries;
+            if (rate > best_rate) {
+                best_rate = rate;
+                actions[state] = class;
+            }
+        }
+        settled += actions[state] != POLICY_UNSET;
+    }
+    return settled;
+}
+
+int policy_train(
+    const char* const path,
+    const char* const opponent,
+    long              games,
+    uint64_t          seed  //
+) {
+    strategy_t check;
+    if (!strategy_open(opponent, &check)) {
+        fprintf(stderr, "unknown strategy '%s', try:\n", opponent);
+        strategy_list(stderr);
+        return 1;
+    }
+    strategy_close(&check);
+    if (games <= 0) ohcrap("the number of games must be positive");
+    check_four_held();
+
+    int       threads = sim_threads();
+    pthread_t tids[threads];
+    trainer_t trainers[threads];
+    tally_t*  total = calloc(1, sizeof(tally_t));
+    uint8_t*  actions = malloc(POLICY_STATES);
+    memset(actions, POLICY_UNSET, POLICY_STATES);
+
+    training_t train = {.opponent = opponent, .seed = seed};
+    for (range(idx, 0, threads, 1))
+        trainers[idx] = (trainer_t){&train, calloc(1, sizeof(tally_t))};
+
+    // every round plays against the table the ones before it settled
+    for (range(round, 0, POLICY_ROUNDS, 1)) {
+        train.actions = actions;
+        atomic_init(&train.next_game, games * round / POLICY_ROUNDS);
+        train.end_game = games * (round + 1) / POLICY_ROUNDS;
+
+        for (range(idx, 0, threads, 1))
+            pthread_create(&tids[idx], NULL, &train_worker, &trainers[idx]);
+        long played = 0, won = 0;
+        for (range(idx, 0, threads, 1)) {
+            pthread_join(tids[idx], NULL);
+            tally_t* tally = trainers[idx].tally;
+            for (range(state, 0, POLICY_STATES, 1))
+                for (range(class, 0, POLICY_CLASSES, 1)) {
+                    total->tries[state][class] += tally->tries[state][class];
+                    total->wins[state][class] += tally->wins[state][class];
+                }
+            played += tally->games;
+            won += tally->won;
+            memset(tally, 0, sizeof(tally_t));
+        }
+
+        int settled = settle(total, actions);
+        printf(
+            "round %i: %li games, won %.2f%% vs %s, %i of %i states "
+            "settled\n",
+            round + 1,
+            played,
+            played > 0 ? 100.0 * won / played : 0,
+            opponent,
+            settled,
+            POLICY_STATES);
+    }
+
+    header_t header = {
+        .magic = POLICY_MAGIC,
+        .version = POLICY_VERSION,
+        .states = POLICY_STATES,
+    };
+    FILE* file = fopen(path, "wb");
+    bool  wrote = file != NULL &&
+                 fwrite(&header, sizeof(header), 1, file) == 1 &&
+                 fwrite(actions, POLICY_STATES, 1, file) == 1;
+    if (file != NULL && fclose(file) != 0) wrote = false;
+    if (!wrote) fprintf(stderr, "couldn't write '%s'\n", path);
+
+    for (range(idx, 0, threads, 1)) free(trainers[idx].tally);
+    free(total);
+    free(actions);
+    return !wrote;
+}
@@ -0,0 +1,94 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "player.h"
+
+/** === [ Policy tables ] ===
+ *
+ * A strategy that looks its answer up instead of working it out. The
+ * state is abstracted down to what matters for which rank to ask:
+ *
+ *   every rank in hand falls in one of 9 classes, by how many of it
+ *   the player holds (1-3, a dealt four counting as three) and what
+ *   the opponent is seen to have of it (see belief.h): some for sure,
+ *   recently none, or unknown
+ *
+ *   the state is how many ranks are in each class (0, 1 or 2+) and how
+ *   far through the deck the game is (4 buckets)
+ *
+ * Ranks are interchangeable, so that's everything; 4 * 3^9 = 78732
+ * states, one byte each naming the class to ask from (the lowest rank
+ * in it). --train-policy fills the table with Monte Carlo control:
+ * games against a fixed opponent with a few random asks mixed in,
+ * each ask credited with whether its game was won, and each state
+ * then asking whichever class won the most once it has been tried
+ * enough. States it never settled answer POLICY_UNSET and fall back to
+ * belief_best_ask.
+ *
+ * The file is a small header and the table, and the "table:<file>"
+ * strategy maps it read only, so opening one costs the same however
+ * big the table is and pages are only read as states come up.
+ */
+
+#define POLICY_CLASSES   9
+#define POLICY_BUCKETS   4      // deck buckets
+#define POLICY_STATES    78732  // POLICY_BUCKETS * 3^POLICY_CLASSES
+#define POLICY_UNSET     0xFF
+#define POLICY_EXPLORE   10     // % of training asks made at random
+#define POLICY_MIN_TRIES 32     // tries of a class before it can win
+#define POLICY_ROUNDS    4      // table rebuilds over a training run
+
+/**
+ * @brief an opened table, the ctx of a "table:<file>" player
+ */
+typedef struct {
+    void*          map;
+    size_t         size;
+    const uint8_t* actions;  // POLICY_STATES of them
+} policy_t;
+
+/**
+ * @brief map a table file
+ *
+ * @exception exits if the file can't be mapped or isn't a table
+ */
+policy_t* policy_open(const char* const path);
+
+void policy_close(policy_t* const);
+
+/**
+ * @brief read_rank for the policy_t in the player's ctx
+ */
+rank_t policy_read_rank(player_t* player);
+
+/**
+ * @brief train a table against `opponent` and write it to `path`
+ *
+ * @return int process exit code
+ */
+int policy_train(
+    const char* const path,
+    const char* const opponent,
+    long              games,
+    uint64_t          seed);
@@ -0,0 +1,114 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include "rng.h"
+
+// the Philox4x32 multipliers and key schedule (Weyl) constants
+#define PHILOX_M0 0xD2511F53u
+#define PHILOX_M1 0xCD9E8D57u
+#define PHILOX_W0 0x9E3779B9u
+#define PHILOX_W1 0xBB67AE85u
+#define PHILOX_ROUNDS 10
+
+static void philox(
+    const uint32_t counter[4],
+    const uint32_t key[2],
+    uint32_t       out[4]  //
+) {
+    uint32_t c0 = counter[0], c1 = counter[1], c2 = counter[2],
+             c3 = counter[3];
+    uint32_t k0 = key[0], k1 = key[1];
+
+    for (range(_, 0, PHILOX_ROUNDS, 1)) {
+        uint64_t p0 = (uint64_t)PHILOX_M0 * c0;
+        uint64_t p1 = (uint64_t)PHILOX_M1 * c2;
+
+        c0 = (uint32_t)(p1 >> 32) ^ c1 ^ k0;
+        c1 = (uint32_t)p1;
+        c2 = (uint32_t)(p0 >> 32) ^ c3 ^ k1;
+        c3 = (uint32_t)p0;
+
+        k0 += PHILOX_W0;
+        k1 += PHILOX_W1;
+    }
+
+    out[0] = c0;
+    out[1] = c1;
+    out[2] = c2;
+    out[3] = c3;
+}
+
+uint64_t rng_mix(uint64_t a, uint64_t b) {
+    return rng_splitmix(a ^ rng_splitmix(b + 0x9e3779b97f4a7c15ull));
+}
+
+void rng_keyed(
+    rng_t* const rng,
+    uint64_t     seed,
+    uint64_t     game,
+    uint32_t     stream  //
+) {
+    *rng = (rng_t){
+        .key = {(uint32_t)seed, (uint32_t)(seed >> 32)},
+        .counter = {(uint32_t)game, (uint32_t)(game >> 32), stream, 0},
+        .used = 2,  // nothing computed yet
+    };
+}
+
+void rng_seed(rng_t* const rng, uint64_t seed) {
+    rng_keyed(rng, seed, 0, 0);
+}
+
+void rng_refill(rng_t* const rng) {
+    uint32_t out[4];
+    philox(rng->counter, rng->key, out);
+    rng->counter[3]++;
+
+    rng->out[0] = (uint64_t)out[1] << 32 | out[0];
+    rng->out[1] = (uint64_t)out[3] << 32 | out[2];
+    rng->used = 0;
+}
+
+err_t rng_self_check() {
+    // from the Random123 distribution's kat_vectors, philox4x32 10 rounds
+    static const struct {
+        uint32_t counter[4], key[2], out[4];
+    } known[] = {
+        {{0, 0, 0, 0},
+         {0, 0},
+         {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8}},
+        {{0xffffffff, 0xffffffff, 0xffffffff, 0xffffffff},
+         {0xffffffff, 0xffffffff},
+         {0x408f276d, 0x41c83b0e, 0xa20bc7c6, 0x6d5451fd}},
+        {{0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+         {0xa4093822, 0x299f31d0},
+         {0xd16cfe09, 0x94fdcceb, 0x5001e420, 0x24126ea1}},
+    };
+
+    for (range(idx, 0, 3, 1)) {
+        uint32_t out[4];
+        philox(known[idx].counter, known[idx].key, out);
+        for (range(word, 0, 4, 1))
+            if (out[word] != known[idx].out[word]) return ERROR;
+    }
+    return SUCCESS;
+}
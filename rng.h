@@ -0,0 +1,109 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+#include "card.h"
+
+/**
+ * @brief a counter based random number generator (Philox4x32-10)
+ *
+ * Rather than stepping a hidden state, every 128 bits of output is a
+ * keyed hash of a counter: the key is the run's seed and the counter is
+ * (game, stream, block). So any game's numbers (say the deck of game
+ * #123456) can be produced directly, without running through the games
+ * before it, and which thread produces them can't change them.
+ *
+ * Unlike rand() each game (and each player) can own one, so games run
+ * side by side, or on other threads, don't disturb each other.
+ */
+typedef struct {
+    uint32_t key[2];
+    uint32_t counter[4];  // game (2 words), stream, block
+    uint64_t out[2];      // the current block's output
+    uint8_t  used;        // how much of out has been handed out
+} rng_t;
+
+/**
+ * @brief the splitmix64 finalizer, a cheap well spread hash of z
+ */
+static inline uint64_t rng_splitmix(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/**
+ * @brief mix two values into one well spread seed, used to derive a
+ * seed from the time and a counter (etc)
+ */
+uint64_t rng_mix(uint64_t a, uint64_t b);
+
+/**
+ * @brief start a generator on one stream of one game of a run
+ *
+ * @param seed the run's seed
+ * @param game the game's number in the run
+ * @param stream which of the game's uses this is (the deck, a seat, ..)
+ */
+void rng_keyed(rng_t* const, uint64_t seed, uint64_t game, uint32_t stream);
+
+/**
+ * @brief (re)start a generator from a seed, same as stream 0 of game 0
+ */
+void rng_seed(rng_t* const, uint64_t seed);
+
+/**
+ * @brief compute the next block of output, see rng_next
+ */
+void rng_refill(rng_t* const);
+
+/**
+ * @brief the next 64 random bits
+ *
+ * Inline (like rng_below) since all but every other call is just a read
+ * of the current block.
+ */
+static inline uint64_t rng_next(rng_t* const rng) {
+    if (rng->used == 2) rng_refill(rng);
+    return rng->out[rng->used++];
+}
+
+/**
+ * @brief a random number in [0, upto)
+ *
+ * Uses a multiply and shift rather than %, the bias this leaves is at
+ * most upto / 2^32 which is nothing for a deck of cards.
+ */
+static inline uint32_t rng_below(rng_t* const rng, uint32_t upto) {
+    return ((rng_next(rng) >> 32) * upto) >> 32;
+}
+
+/**
+ * @brief the Philox4x32-10 known answer tests, to make sure a build
+ * produces the reference generator's numbers
+ *
+ * @return err_t ERROR if any block differs
+ */
+err_t rng_self_check();
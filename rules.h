@@ -0,0 +1,49 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stdint.h>
+
+/** === [ Rules ] ===
+ *
+ * The numbers the game is played with. play_turn and friends play the
+ * standard game, with these as compile time constants; variant.h plays
+ * other values of them.
+ */
+
+#define RULES_HAND   7  // cards dealt to each player
+#define RULES_BOOK   4  // cards of a rank that make a book
+#define RULES_TO_WIN 7  // books needed to win
+
+/**
+ * @brief a set of rules, see variant.h
+ *
+ * With books of fewer than 4 cards, the rest of a rank leaves the game
+ * when it's booked. If nobody can reach `to_win` (more than half of the
+ * 13 ranks) the game ends when every rank is booked, most books winning.
+ */
+typedef struct {
+    uint8_t hand;    // 1 .. 26
+    uint8_t book;    // 2 .. 4
+    uint8_t to_win;  // 1 .. 13
+} rules_t;
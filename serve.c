@@ -0,0 +1,692 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdarg.h>
+#include <ctype.h>
+
+#include "serve.h"
+#include "sim.h"
+
+#ifdef __linux__
+
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <time.h>
+#    include <unistd.h>
+#    include <arpa/inet.h>
+#    include <netinet/in.h>
+#    include <sys/epoll.h>
+#    include <sys/resource.h>
+#    include <sys/socket.h>
+#    include <sys/un.h>
+
+#    define SERVE_LINE_MAX 16    // longest line a client may send
+#    define SERVE_OUT_MAX  4096  // unsent output allowed before dropping
+#    define SERVE_EVENTS   256   // events handled per epoll_wait
+
+/* === [ sockets ] === */
+
+typedef struct {
+    struct sockaddr_storage addr;
+    socklen_t               len;
+} sock_addr_t;
+
+static err_t parse_addr(const char* const str, sock_addr_t* const into) {
+    memset(into, 0, sizeof(*into));
+
+    if (strncmp(str, "unix:", 5) == 0) {
+        struct sockaddr_un* un = (struct sockaddr_un*)&into->addr;
+        const char*         path = &str[5];
+        if (strlen(path) == 0 || strlen(path) >= sizeof(un->sun_path))
+            return ERROR;
+        un->sun_family = AF_UNIX;
+        strcpy(un->sun_path, path);
+        into->len = sizeof(*un);
+        return SUCCESS;
+    }
+
+    if (strncmp(str, "tcp:", 4) == 0) {
+        struct sockaddr_in* in = (struct sockaddr_in*)&into->addr;
+        int                 port = atoi(&str[4]);
+        if (port <= 0 || port > 65535) return ERROR;
+        in->sin_family = AF_INET;
+        in->sin_port = htons(port);
+        in->sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        into->len = sizeof(*in);
+        return SUCCESS;
+    }
+
+    return ERROR;
+}
+
+static void set_nonblocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    if (flags < 0 || fcntl(fd, F_SETFL, flags | O_NONBLOCK) < 0)
+        ohcrap("unable to make a socket non-blocking");
+}
+
+// every connection is an fd, so let it have as many as the system allows
+static void raise_fd_limit() {
+    struct rlimit lim;
+    if (getrlimit(RLIMIT_NOFILE, &lim) != 0) return;
+    lim.rlim_cur = lim.rlim_max;
+    setrlimit(RLIMIT_NOFILE, &lim);
+}
+
+/* === [ tables ] === */
+
+typedef enum __attribute__((__packed__)) {
+    TABLE_AWAIT_RANK,
+    TABLE_AWAIT_AGAIN,
+    TABLE_CLOSING,
+} table_state_t;
+
+/**
+ * @brief one connection and the game being played over it
+ *
+ * Sized up front so an idle table costs the same as a busy one, the
+ * output buffer is the only thing allocated on demand and is released
+ * once it has been sent.
+ */
+typedef struct {
+    int           fd;
+    table_state_t state;
+    bool          want_out;    // EPOLLOUT is registered
+    bool          discarding;  // dropping the rest of an overlong line
+    uint8_t       in_len;
+    char          in[SERVE_LINE_MAX];
+    rank_t        pending;  // what table_read_rank answers with
+    player_t      user;
+    player_t      compy;
+    deck_t        deck;
+    char*         out;  // nullable, only held while output is pending
+    size_t        out_len;
+} table_t;
+
+static rank_t table_read_rank(player_t* player) {
+    // the rank was already validated before the turn was played
+    return ((table_t*)player->ctx)->pending;
+}
+
+static int count_books(const player_t* const player) {
+    int count = 0;
+    while (count < RULES_TO_WIN && player->books[count] != RANK_NULL)
+        count++;
+    return count;
+}
+
+static void table_send(table_t* const t, const char* const fmt, ...) {
+    if (t->state == TABLE_CLOSING) return;
+
+    char    line[256];
+    va_list args;
+    va_start(args, fmt);
+    int len = vsnprintf(line, sizeof(line), fmt, args);
+    va_end(args);
+
+    // a client that stops reading does not get to grow the table
+    if (len < 0 || t->out_len + len > SERVE_OUT_MAX) {
+        t->state = TABLE_CLOSING;
+        t->out_len = 0;
+        return;
+    }
+
+    if (t->out == NULL) t->out = malloc(SERVE_OUT_MAX);
+    memcpy(&t->out[t->out_len], line, len);
+    t->out_len += len;
+}
+
+static void table_prompt(table_t* const t) {
+    switch (t->state) {
+        case TABLE_AWAIT_RANK: {
+            char  hand[52 * 3 + 1] = {0};
+            char* end = hand;
+            for (hand_node_t node = t->user.hand.head; node != NULL;
+                 node = node->next)
+                end += sprintf(
+                    end, " %s", rank_as_str(card_idx_rank(node->card)));
+            table_send(
+                t,
+                "R %i %i %i %zu%s\n",
+                t->deck.remaining,
+                count_books(&t->user),
+                count_books(&t->compy),
+                t->compy.hand.length,
+                hand);
+            break;
+        }
+        case TABLE_AWAIT_AGAIN:
+            table_send(
+                t,
+                "A %i %i %i\n",
+                count_books(&t->user) == RULES_TO_WIN,
+                count_books(&t->user),
+                count_books(&t->compy));
+            break;
+        case TABLE_CLOSING:
+            break;
+    }
+}
+
+// plays the computer's turn(s), returns true if that ended the game
+static bool table_compy_turns(table_t* const t) {
+    turn_result_t result;
+    do result = play_turn(
+        &t->compy, &t->user, &t->deck, &t->user, &t->compy);
+    while (result == TURN_EXTRA);
+
+    if (result == TURN_WON) {
+        t->state = TABLE_AWAIT_AGAIN;
+        table_prompt(t);
+        return true;
+    }
+    return false;
+}
+
+// runs turns until the user has something to answer
+static void table_user_turn(table_t* const t) {
+    for (;;) {
+        if (play_turn_draw_up(&t->user, &t->deck)) {
+            t->state = TABLE_AWAIT_RANK;
+            table_prompt(t);
+            return;
+        }
+        // the user had to pass
+        if (table_compy_turns(t)) return;
+    }
+}
+
+static void table_new_game(table_t* const t) {
+    player_cleanup(&t->user);
+    player_cleanup(&t->compy);
+
+    // players have const members, so they're copied in rather than
+    // assigned
+    player_t user = player_init("Player 1", true, &table_read_rank);
+    player_t compy = player_init("Player 2", false, &play_compy_turn);
+    memcpy(&t->user, &user, sizeof(user));
+    memcpy(&t->compy, &compy, sizeof(compy));
+    t->user.ctx = t;
+    player_seat(&t->user, &t->compy, &t->deck);
+
+    deck_init(&t->deck);
+    deck_shuffle(&t->deck);
+    player_deal_cards(&t->user, &t->deck, RULES_HAND);
+    player_deal_cards(&t->compy, &t->deck, RULES_HAND);
+
+    table_user_turn(t);
+}
+
+static void table_on_line(table_t* const t, const char* const line) {
+    switch (t->state) {
+        case TABLE_AWAIT_RANK: {
+            rank_t rank = rank_from_str((char*)line);
+            if (rank == RANK_NULL || !hand_has_rank(&t->user.hand, rank)) {
+                table_send(t, "X not a rank in your hand\n");
+                table_prompt(t);
+                return;
+            }
+
+            t->pending = rank;
+            turn_result_t result = play_turn(
+                &t->user, &t->compy, &t->deck, &t->user, &t->compy);
+            switch (result) {
+                case TURN_WON:
+                    t->state = TABLE_AWAIT_AGAIN;
+                    table_prompt(t);
+                    return;
+                case TURN_EXTRA:
+                    break;
+                case TURN_NEXT:
+                    if (table_compy_turns(t)) return;
+                    break;
+            }
+            table_user_turn(t);
+            return;
+        }
+        case TABLE_AWAIT_AGAIN:
+            switch (toupper(line[0])) {
+                case 'Y':
+                    table_new_game(t);
+                    return;
+                case 'N':
+                    t->state = TABLE_CLOSING;
+                    return;
+                default:
+                    table_send(t, "X answer Y or N\n");
+                    table_prompt(t);
+                    return;
+            }
+        case TABLE_CLOSING:
+            return;
+    }
+}
+
+static table_t* table_open(int fd) {
+    table_t* t = calloc(1, sizeof(table_t));
+    t->fd = fd;
+    table_new_game(t);
+    return t;
+}
+
+static void table_close(table_t* const t) {
+    close(t->fd);  // also removes it from the epoll set
+    player_cleanup(&t->user);
+    player_cleanup(&t->compy);
+    free(t->out);
+    free(t);
+}
+
+/**
+ * @brief send what can be sent without blocking
+ *
+ * @return false if the table was closed
+ */
+static bool table_flush(table_t* const t, int epfd) {
+    size_t sent = 0;
+    while (sent < t->out_len) {
+        ssize_t n =
+            send(t->fd, &t->out[sent], t->out_len - sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            sent += n;
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            table_close(t);
+            return false;
+        }
+    }
+
+    t->out_len -= sent;
+    if (t->out_len > 0) {
+        memmove(t->out, &t->out[sent], t->out_len);
+    } else {
+        free(t->out);
+        t->out = NULL;
+        if (t->state == TABLE_CLOSING) {
+            table_close(t);
+            return false;
+        }
+    }
+
+    // only ask to hear about writability while there's something to write
+    bool want_out = t->out_len > 0;
+    if (want_out != t->want_out) {
+        struct epoll_event ev = {
+            .events = EPOLLIN | (want_out ? EPOLLOUT : 0), .data.ptr = t};
+        epoll_ctl(epfd, EPOLL_CTL_MOD, t->fd, &ev);
+        t->want_out = want_out;
+    }
+    return true;
+}
+
+/**
+ * @brief read and act on everything the client has sent
+ *
+ * @return false if the table was closed
+ */
+static bool table_on_readable(table_t* const t, int epfd) {
+    char buf[512];
+    for (;;) {
+        ssize_t n = recv(t->fd, buf, sizeof(buf), 0);
+        if (n == 0 || (n < 0 && errno != EAGAIN && errno != EWOULDBLOCK &&
+                       errno != EINTR)) {
+            table_close(t);
+            return false;
+        }
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0) break;
+
+        for (range(idx, 0, n, 1)) {
+            char c = buf[idx];
+            if (c == '\r') continue;
+            if (c != '\n') {
+                if (t->in_len + 1 < SERVE_LINE_MAX)
+                    t->in[t->in_len++] = c;
+                else
+                    t->discarding = true;
+                continue;
+            }
+
+            t->in[t->in_len] = '\0';
+            if (t->discarding) {
+                table_send(t, "X line too long\n");
+                table_prompt(t);
+            } else {
+                table_on_line(t, t->in);
+            }
+            t->in_len = 0;
+            t->discarding = false;
+        }
+    }
+
+    if (t->state == TABLE_CLOSING && t->out_len == 0) {
+        table_close(t);
+        return false;
+    }
+    return table_flush(t, epfd);
+}
+
+/* === [ server ] === */
+
+int serve_listen(const char* const addr) {
+    sock_addr_t sa;
+    if (!parse_addr(addr, &sa)) ohcrap("invalid address, see --help");
+
+    int fd = socket(sa.addr.ss_family, SOCK_STREAM | SOCK_NONBLOCK, 0);
+    if (fd < 0) ohcrap("unable to open the listening socket");
+
+    if (sa.addr.ss_family == AF_UNIX) {
+        unlink(((struct sockaddr_un*)&sa.addr)->sun_path);
+    } else {
+        int yes = 1;
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &yes, sizeof(yes));
+    }
+
+    if (bind(fd, (struct sockaddr*)&sa.addr, sa.len) != 0)
+        ohcrap("unable to bind the listening socket");
+    if (listen(fd, SOMAXCONN) != 0)
+        ohcrap("unable to listen on the listening socket");
+    return fd;
+}
+
+int serve_dial(const char* const addr) {
+    sock_addr_t sa;
+    if (!parse_addr(addr, &sa)) ohcrap("invalid address, see --help");
+
+    int fd = socket(sa.addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) ohcrap("unable to open a client socket");
+    if (connect(fd, (struct sockaddr*)&sa.addr, sa.len) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static void serve_accept(int lfd, int epfd) {
+    for (;;) {
+        int fd = accept4(lfd, NULL, NULL, SOCK_NONBLOCK);
+        if (fd < 0) {
+            // out of fds: leave the rest in the backlog until some close
+            if (errno == EMFILE || errno == ENFILE)
+                fprintf(stderr, "warning: out of file descriptors\n");
+            return;
+        }
+
+        table_t*           t = table_open(fd);
+        struct epoll_event ev = {.events = EPOLLIN, .data.ptr = t};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, fd, &ev) != 0) {
+            table_close(t);
+            continue;
+        }
+        table_flush(t, epfd);
+    }
+}
+
+int serve_run(const char* const addr) {
+    raise_fd_limit();
+
+    int lfd = serve_listen(addr);
+    int epfd = epoll_create1(0);
+    if (epfd < 0) ohcrap("unable to create an epoll instance");
+
+    // the listening socket is the only event without a table
+    struct epoll_event ev = {.events = EPOLLIN, .data.ptr = NULL};
+    if (epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev) != 0)
+        ohcrap("unable to watch the listening socket");
+
+    fprintf(stderr, "serving go fish on %s\n", addr);
+
+    struct epoll_event events[SERVE_EVENTS];
+    for (;;) {
+        int count = epoll_wait(epfd, events, SERVE_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            ohcrap("epoll_wait failed");
+        }
+
+        for (range(idx, 0, count, 1)) {
+            table_t* t = events[idx].data.ptr;
+            uint32_t what = events[idx].events;
+
+            if (t == NULL) {
+                serve_accept(lfd, epfd);
+                continue;
+            }
+
+            // each table shows up at most once per batch, so closing
+            // one here cannot leave a dangling event behind
+            if (what & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+                if (!table_on_readable(t, epfd)) continue;
+            }
+            if (what & EPOLLOUT) table_flush(t, epfd);
+        }
+    }
+}
+
+/* === [ load generator ] === */
+
+typedef struct {
+    int      fd;
+    int      games_left;
+    bool     done;
+    uint16_t in_len;
+    char     in[512];
+    uint64_t asked_at;  // 0 while no ask is outstanding
+} client_t;
+
+typedef struct {
+    uint64_t* ns;
+    size_t    length;
+    size_t    capacity;
+} latencies_t;
+
+static void latencies_push(latencies_t* const lat, uint64_t ns) {
+    if (lat->length == lat->capacity) {
+        lat->capacity = lat->capacity ? lat->capacity * 2 : 4096;
+        lat->ns = realloc(lat->ns, lat->capacity * sizeof(uint64_t));
+    }
+    lat->ns[lat->length++] = ns;
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+static int client_connect(const sock_addr_t* const sa) {
+    int fd = socket(sa->addr.ss_family, SOCK_STREAM, 0);
+    if (fd < 0) ohcrap("unable to open a client socket");
+    // connect blocking (it's local), then switch over
+    if (connect(fd, (struct sockaddr*)&sa->addr, sa->len) != 0)
+        ohcrap("unable to connect to the server");
+    set_nonblocking(fd);
+    return fd;
+}
+
+static void client_send(client_t* const c, const char* const str) {
+    // replies are tiny and the socket buffer is empty, a short write
+    // here means the server is gone
+    size_t len = strlen(str);
+    if (send(c->fd, str, len, MSG_NOSIGNAL) != (ssize_t)len)
+        ohcrap("the server stopped reading");
+}
+
+static void client_on_line(
+    client_t* const    c,
+    char* const        line,
+    latencies_t* const lat) {
+    uint64_t now = sim_now_ns();
+    if (c->asked_at != 0 && (line[0] == 'R' || line[0] == 'A'))
+        latencies_push(lat, now - c->asked_at);
+    c->asked_at = 0;
+
+    switch (line[0]) {
+        case 'R': {
+            // skip the tag and the four counts, the rest is the hand
+            char* ranks[52];
+            int   count = 0;
+            char* save = NULL;
+            char* tok = strtok_r(line, " ", &save);
+            for (int field = 0; tok != NULL;
+                 tok = strtok_r(NULL, " ", &save), field++)
+                if (field >= 5 && count < 52) ranks[count++] = tok;
+            if (count == 0) ohcrap("the server prompted with an empty hand");
+
+            char reply[8];
+            snprintf(reply, sizeof(reply), "%s\n", ranks[rand() % count]);
+            c->asked_at = sim_now_ns();
+            client_send(c, reply);
+            break;
+        }
+        case 'A':
+            c->games_left--;
+            client_send(c, c->games_left > 0 ? "Y\n" : "N\n");
+            if (c->games_left > 0) c->asked_at = sim_now_ns();
+            break;
+        default:
+            ohcrap("the server rejected a line from the load generator");
+    }
+}
+
+int serve_loadgen(const char* const addr, int conns, int games, int idle) {
+    sock_addr_t sa;
+    if (!parse_addr(addr, &sa)) ohcrap("invalid address, see --help");
+    if (conns <= 0 || games <= 0 || idle < 0)
+        ohcrap("connection and game counts must be positive");
+
+    raise_fd_limit();
+    srand(time(NULL));
+
+    // the idle connections are opened first so the active ones are
+    // measured against a server already holding them
+    int* idle_fds = malloc(sizeof(int) * (idle + 1));
+    for (range(idx, 0, idle, 1)) idle_fds[idx] = client_connect(&sa);
+    fprintf(stderr, "opened %i idle connections\n", idle);
+
+    int epfd = epoll_create1(0);
+    if (epfd < 0) ohcrap("unable to create an epoll instance");
+
+    client_t* clients = calloc(conns, sizeof(client_t));
+    uint64_t  start = sim_now_ns();
+    for (range(idx, 0, conns, 1)) {
+        clients[idx].fd = client_connect(&sa);
+        clients[idx].games_left = games;
+        struct epoll_event ev = {
+            .events = EPOLLIN, .data.ptr = &clients[idx]};
+        if (epoll_ctl(epfd, EPOLL_CTL_ADD, clients[idx].fd, &ev) != 0)
+            ohcrap("unable to watch a client socket");
+    }
+
+    latencies_t        lat = {0};
+    int                remaining = conns;
+    struct epoll_event events[SERVE_EVENTS];
+    while (remaining > 0) {
+        int count = epoll_wait(epfd, events, SERVE_EVENTS, -1);
+        if (count < 0) {
+            if (errno == EINTR) continue;
+            ohcrap("epoll_wait failed");
+        }
+
+        for (range(idx, 0, count, 1)) {
+            client_t* c = events[idx].data.ptr;
+            char      buf[4096];
+            ssize_t   n;
+            while ((n = recv(c->fd, buf, sizeof(buf), 0)) > 0) {
+                for (range(b, 0, n, 1)) {
+                    if (buf[b] != '\n') {
+                        if (c->in_len + 1 < sizeof(c->in))
+                            c->in[c->in_len++] = buf[b];
+                        continue;
+                    }
+                    c->in[c->in_len] = '\0';
+                    client_on_line(c, c->in, &lat);
+                    c->in_len = 0;
+                }
+            }
+
+            // the server hangs up after the last N
+            if (!c->done && (n == 0 || (n < 0 && errno != EAGAIN &&
+                                        errno != EWOULDBLOCK))) {
+                if (c->games_left > 0)
+                    ohcrap("the server closed a connection mid-game");
+                close(c->fd);
+                c->done = true;
+                remaining--;
+            }
+        }
+    }
+    uint64_t elapsed = sim_now_ns() - start;
+
+    for (range(idx, 0, idle, 1)) close(idle_fds[idx]);
+
+    qsort(lat.ns, lat.length, sizeof(uint64_t), &cmp_u64);
+    double secs = elapsed / 1e9;
+    printf(
+        "%i connections (+%i idle) x %i games in %.3fs\n"
+        "%zu responses, %.0f responses/sec, %.0f games/sec\n",
+        conns,
+        idle,
+        games,
+        secs,
+        lat.length,
+        lat.length / secs,
+        (double)conns * games / secs);
+    if (lat.length > 0)
+        printf(
+            "ask-to-response latency: p50 %.1fus  p99 %.1fus  max %.1fus\n",
+            lat.ns[lat.length / 2] / 1e3,
+            lat.ns[(lat.length * 99) / 100] / 1e3,
+            lat.ns[lat.length - 1] / 1e3);
+
+    free(lat.ns);
+    free(clients);
+    free(idle_fds);
+    close(epfd);
+    return 0;
+}
+
+#else  // !__linux__
+
+int serve_listen(const char* const addr) {
+    ohcrap("sockets are only set up on linux");
+}
+
+int serve_dial(const char* const addr) {
+    ohcrap("sockets are only set up on linux");
+}
+
+int serve_run(const char* const addr) {
+    ohcrap("--serve is built on epoll, which is linux only");
+}
+
+int serve_loadgen(const char* const addr, int conns, int games, int idle) {
+    ohcrap("--loadgen is built on epoll, which is linux only");
+}
+
+#endif
@@ -0,0 +1,85 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "gofish.h"
+
+/** === [ Table protocol ] ===
+ *
+ * Every connection is its own table: the remote end is "Player 1" and
+ * the computer is "Player 2". Everything is newline terminated ascii, one
+ * message per line, the first character says what the line is.
+ *
+ * server -> client
+ *   R <deck> <your books> <their books> <their hand size> <rank>...
+ *       your turn, answer with one of the listed ranks (your hand)
+ *   A <1 if you won else 0> <your books> <their books>
+ *       the game is over, answer Y to play again or N to leave
+ *   X <reason>
+ *       the last line was rejected, the prompt that follows repeats
+ *
+ * client -> server
+ *   a rank as typed in the interactive game ("2".."10", "J", "Q", "K",
+ *   "A") after an R, or Y / N after an A
+ *
+ * Turn narration is not sent, the next prompt carries all the state a
+ * client needs.
+ */
+
+/**
+ * @brief host tables for remote players until killed
+ *
+ * @param addr unix:<path> or tcp:<port> (bound to loopback)
+ * @return int process exit code
+ */
+int serve_run(const char* const addr);
+
+/**
+ * @brief hammer a running server and report ask-to-response latency
+ *
+ * Each active connection plays `games` games asking for random ranks
+ * from its hand as fast as answers come back, the idle connections just
+ * connect and sit there for the duration.
+ *
+ * @param addr the same address given to --serve
+ * @param conns number of connections actively playing
+ * @param games games played per active connection
+ * @param idle number of extra connections that never answer
+ * @return int process exit code
+ */
+int serve_loadgen(const char* const addr, int conns, int games, int idle);
+
+/**
+ * @brief a non-blocking listening socket on `addr`, as --serve takes
+ * it, for the other things served over a socket (see metrics.h)
+ *
+ * @exception exits if the address is invalid or can't be bound
+ */
+int serve_listen(const char* const addr);
+
+/**
+ * @brief a blocking client socket connected to `addr`
+ *
+ * @return int the fd, -1 if nothing is listening there
+ */
+int serve_dial(const char* const addr);
@@ -0,0 +1,298 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "shm.h"
+#include "sim.h"
+
+#ifdef __linux__
+
+#    include <errno.h>
+#    include <fcntl.h>
+#    include <time.h>
+#    include <unistd.h>
+#    include <linux/futex.h>
+#    include <sys/mman.h>
+#    include <sys/syscall.h>
+
+// on one core the other side can't run while we spin, so don't
+static int spins() {
+    static int count = -1;
+    if (count < 0)
+        count = sysconf(_SC_NPROCESSORS_ONLN) > 1 ? SHM_SPINS : 0;
+    return count;
+}
+
+static inline void cpu_relax() {
+#    if defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#    endif
+}
+
+/**
+ * @brief wait for `counter` to move past `seen`
+ *
+ * @param asleep the flag the other side checks before waking us
+ * @param timeout_ms -1 waits forever
+ * @return err_t ERROR on a timeout
+ */
+static err_t wait_past(
+    _Atomic uint32_t* const counter,
+    _Atomic uint32_t* const asleep,
+    uint32_t                seen,
+    int                     timeout_ms  //
+) {
+    for (range(_, 0, spins(), 1)) {
+        if (atomic_load_explicit(counter, memory_order_acquire) != seen)
+            return SUCCESS;
+        cpu_relax();
+    }
+
+    uint64_t deadline = sim_now_ns() + (uint64_t)timeout_ms * 1000000;
+    for (;;) {
+        // announce the nap, then re-check so a bump between the check
+        // and the futex_wait can't be missed (the other side bumps,
+        // then looks at the flag)
+        atomic_store(asleep, 1);
+        if (atomic_load(counter) != seen) break;
+
+        struct timespec  rel;
+        struct timespec* timeout = NULL;
+        if (timeout_ms >= 0) {
+            uint64_t now = sim_now_ns();
+            if (now >= deadline) {
+                atomic_store(asleep, 0);
+                return ERROR;
+            }
+            rel.tv_sec = (deadline - now) / 1000000000;
+            rel.tv_nsec = (deadline - now) % 1000000000;
+            timeout = &rel;
+        }
+        syscall(SYS_futex, counter, FUTEX_WAIT, seen, timeout, NULL, 0);
+    }
+    atomic_store(asleep, 0);
+    return SUCCESS;
+}
+
+static void bump_and_wake(
+    _Atomic uint32_t* const counter,
+    _Atomic uint32_t* const asleep  //
+) {
+    atomic_fetch_add(counter, 1);
+    if (atomic_load(asleep))
+        syscall(SYS_futex, counter, FUTEX_WAKE, 1, NULL, NULL, 0);
+}
+
+// shm_open wants exactly one leading slash
+static void shm_path(const char* const name, char* const path, size_t len) {
+    snprintf(path, len, "%s%s", name[0] == '/' ? "" : "/", name);
+}
+
+static shm_ring_t* shm_map(const char* const name, bool create) {
+    char path[256];
+    shm_path(name, path, sizeof(path));
+
+    int fd = shm_open(path, O_RDWR | (create ? O_CREAT : 0), 0600);
+    if (fd < 0) ohcrap("unable to open the shared memory ring");
+    if (create && ftruncate(fd, sizeof(shm_ring_t)) != 0)
+        ohcrap("unable to size the shared memory ring");
+
+    shm_ring_t* ring = mmap(
+        NULL,
+        sizeof(shm_ring_t),
+        PROT_READ | PROT_WRITE,
+        MAP_SHARED,
+        fd,
+        0);
+    close(fd);
+    if (ring == MAP_FAILED) ohcrap("unable to map the shared memory ring");
+    return ring;
+}
+
+shm_ring_t* shm_create(const char* const name) {
+    shm_ring_t* ring = shm_map(name, true);
+    memset(ring, 0, sizeof(shm_ring_t));
+    return ring;
+}
+
+shm_ring_t* shm_attach(const char* const name) {
+    return shm_map(name, false);
+}
+
+void shm_close(shm_ring_t* const ring, bool is_engine) {
+    if (is_engine) {
+        // closing counts as a request so a sleeping strategy wakes up
+        atomic_store(&ring->closed, 1);
+        bump_and_wake(&ring->requests, &ring->strategy_asleep);
+    }
+    munmap(ring, sizeof(shm_ring_t));
+}
+
+rank_t shm_read_rank(player_t* player) {
+    shm_ring_t* ring = player->ctx;
+    uint32_t    seq = atomic_load(&ring->requests);
+    uint32_t    slot = seq % SHM_RING_SLOTS;
+
+    bot_observe(player, &ring->obs[slot]);
+    bump_and_wake(&ring->requests, &ring->strategy_asleep);
+
+    // answers trails requests by exactly this one outstanding ask
+    if (!wait_past(
+            &ring->answers, &ring->engine_asleep, seq, SHM_TIMEOUT_MS))
+        ohcrap("the shared memory strategy did not answer in time");
+
+    uint8_t rank = ring->ranks[slot];
+    if (rank >= 13 || ring->obs[slot].hand[rank] == 0)
+        ohcrap("the shared memory strategy asked for a rank not held");
+    return rank + RANK_2;
+}
+
+/* === [ benchmarking ] === */
+
+typedef struct {
+    shm_ring_t* ring;
+    uint64_t*   ns;  // round trip of every decision
+    size_t      length;
+    size_t      capacity;
+} timed_ring_t;
+
+static rank_t timed_read_rank(player_t* player) {
+    timed_ring_t* timed = player->ctx;
+    if (timed->length == timed->capacity) {
+        timed->capacity = timed->capacity ? timed->capacity * 2 : 4096;
+        timed->ns = realloc(timed->ns, timed->capacity * sizeof(uint64_t));
+    }
+
+    // swap the ring in for the duration of the real call
+    player->ctx = timed->ring;
+    uint64_t start = sim_now_ns();
+    rank_t   rank = shm_read_rank(player);
+    timed->ns[timed->length++] = sim_now_ns() - start;
+    player->ctx = timed;
+    return rank;
+}
+
+static int cmp_u64(const void* a, const void* b) {
+    uint64_t x = *(const uint64_t*)a, y = *(const uint64_t*)b;
+    return (x > y) - (x < y);
+}
+
+int shm_play(const char* const name, const char* const cmd, int games) {
+    if (games <= 0) ohcrap("the number of games must be positive");
+
+    timed_ring_t timed = {.ring = shm_create(name)};
+    bot_t*       strategy = bot_spawn(cmd);
+
+    int      wins = 0;
+    uint64_t start = sim_now_ns();
+    for (range(game, 0, games, 1)) {
+        player_t shm = player_init("Shm", false, &timed_read_rank);
+        player_t compy = player_init("Compy", false, &play_compy_turn);
+        deck_t   deck;
+        shm.ctx = &timed;
+        deck_init(&deck);
+        deck_shuffle(&deck);
+
+        // alternate who moves first
+        player_t* winner = game % 2 == 0
+                               ? play_game_between(&shm, &compy, &deck)
+                               : play_game_between(&compy, &shm, &deck);
+        wins += winner == &shm;
+
+        player_cleanup(&shm);
+        player_cleanup(&compy);
+    }
+    double secs = (sim_now_ns() - start) / 1e9;
+
+    shm_close(timed.ring, true);
+    bot_close(strategy);
+
+    char path[256];
+    shm_path(name, path, sizeof(path));
+    shm_unlink(path);
+
+    qsort(timed.ns, timed.length, sizeof(uint64_t), &cmp_u64);
+    printf(
+        "%i games, strategy won %i (%.1f%%), %.0f games/sec\n",
+        games,
+        wins,
+        100.0 * wins / games,
+        games / secs);
+    if (timed.length > 0)
+        printf(
+            "%zu decisions, round trip p50 %.0fns p99 %.0fns max %.0fns\n",
+            timed.length,
+            (double)timed.ns[timed.length / 2],
+            (double)timed.ns[(timed.length * 99) / 100],
+            (double)timed.ns[timed.length - 1]);
+
+    free(timed.ns);
+    return 0;
+}
+
+int shm_example_main(const char* const name) {
+    shm_ring_t* ring = shm_attach(name);
+    uint32_t    seen = atomic_load(&ring->answers);
+
+    for (;;) {
+        wait_past(&ring->requests, &ring->strategy_asleep, seen, -1);
+        if (atomic_load(&ring->closed)) break;
+
+        uint32_t slot = seen % SHM_RING_SLOTS;
+        ring->ranks[slot] = bot_example_pick(&ring->obs[slot]);
+        seen++;
+        bump_and_wake(&ring->answers, &ring->engine_asleep);
+    }
+
+    shm_close(ring, false);
+    return 0;
+}
+
+#else  // !__linux__
+
+shm_ring_t* shm_create(const char* const name) {
+    ohcrap("shared memory strategies use futexes, which are linux only");
+}
+
+shm_ring_t* shm_attach(const char* const name) {
+    ohcrap("shared memory strategies use futexes, which are linux only");
+}
+
+void shm_close(shm_ring_t* const ring, bool is_engine) {}
+
+rank_t shm_read_rank(player_t* player) {
+    ohcrap("shared memory strategies use futexes, which are linux only");
+}
+
+int shm_play(const char* const name, const char* const cmd, int games) {
+    ohcrap("shared memory strategies use futexes, which are linux only");
+}
+
+int shm_example_main(const char* const name) {
+    ohcrap("shared memory strategies use futexes, which are linux only");
+}
+
+#endif
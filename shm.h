@@ -0,0 +1,105 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stdatomic.h>
+
+#include "bot.h"
+
+/** === [ Shared memory strategies ] ===
+ *
+ * The same observations the pipe bots get (bot_obs_t), passed through a
+ * single producer / single consumer ring in a POSIX shared memory object
+ * instead. The engine publishes an observation by bumping `requests`,
+ * the strategy answers in the matching `ranks` slot and bumps `answers`.
+ * Each side spins briefly on the other's counter before sleeping on it
+ * with a futex, and only makes the wake syscall if the other side is
+ * actually asleep, so a warm round trip never enters the kernel.
+ */
+
+#define SHM_RING_SLOTS 64    // power of two
+#define SHM_SPINS      4096  // polls of the other side before sleeping
+#define SHM_TIMEOUT_MS 1000  // how long a strategy may take per answer
+
+/**
+ * @brief the layout of the shared memory object, both processes must
+ * be built from the same version of this struct
+ */
+typedef struct {
+    // written by the engine, each counter on its own cache line
+    _Alignas(64) _Atomic uint32_t requests;
+    _Atomic uint32_t engine_asleep;
+    _Atomic uint32_t closed;
+    // written by the strategy
+    _Alignas(64) _Atomic uint32_t answers;
+    _Atomic uint32_t strategy_asleep;
+    // the ring itself, indexed by counter % SHM_RING_SLOTS
+    _Alignas(64) bot_obs_t obs[SHM_RING_SLOTS];
+    uint8_t ranks[SHM_RING_SLOTS];
+} shm_ring_t;
+
+/**
+ * @brief create (or reset) the named ring, the engine's side
+ *
+ * @param name the shared memory object's name, "/" is prefixed if
+ * missing
+ * @exception exits if the object cannot be created and mapped
+ */
+shm_ring_t* shm_create(const char* const name);
+
+/**
+ * @brief map an existing ring, the strategy's side
+ *
+ * @exception exits if the object cannot be opened and mapped
+ */
+shm_ring_t* shm_attach(const char* const name);
+
+/**
+ * @brief tell the strategy to exit (engine side only) and unmap
+ */
+void shm_close(shm_ring_t* const ring, bool is_engine);
+
+/**
+ * @brief read_rank backed by the shm_ring_t in the player's ctx
+ *
+ * @exception exits if the strategy does not answer in time
+ */
+rank_t shm_read_rank(player_t* player);
+
+/**
+ * @brief play `games` games of a shared memory strategy against the
+ * computer and report the round trip latency
+ *
+ * @param name the ring to create
+ * @param cmd run with /bin/sh -c, should attach to `name` and answer
+ * @return int process exit code
+ */
+int shm_play(const char* const name, const char* const cmd, int games);
+
+/**
+ * @brief a reference strategy on the named ring, answering with
+ * bot_example_pick until the engine closes the ring
+ *
+ * @return int process exit code
+ */
+int shm_example_main(const char* const name);
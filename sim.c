@@ -0,0 +1,290 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include "sim.h"
+#include "dealer.h"
+#include "endgame.h"
+
+static int count_books(const player_t* const player) {
+    int count = 0;
+    while (count < RULES_TO_WIN && player->books[count] != RANK_NULL)
+        count++;
+    return count;
+}
+
+void sim_deal(
+    deck_t* const decks,
+    uint64_t      seed,
+    uint64_t      first,
+    int           count  //
+) {
+    rng_t rngs[count];
+    for (range(idx, 0, count, 1)) {
+        deck_init(&decks[idx]);
+        rng_keyed(&rngs[idx], seed, first + idx, SIM_STREAM_DECK);
+    }
+    deck_shuffle_many(decks, rngs, count);
+}
+
+sim_result_t sim_play(
+    const strategy_t* const seats[2],
+    uint64_t                seed,
+    uint64_t                game  //
+) {
+    deck_t deck;
+    sim_deal(&deck, seed, game, 1);
+    return sim_play_dealt(seats, seed, game, &deck);
+}
+
+sim_result_t sim_play_dealt(
+    const strategy_t* const seats[2],
+    uint64_t                seed,
+    uint64_t                game,
+    const deck_t* const     dealt  //
+) {
+    player_t players[2] = {
+        strategy_player(seats[0], "Seat 0"),
+        strategy_player(seats[1], "Seat 1"),
+    };
+    rng_keyed(&players[0].rng, seed, game, SIM_STREAM_SEAT + 0);
+    rng_keyed(&players[1].rng, seed, game, SIM_STREAM_SEAT + 1);
+
+    deck_t deck = *dealt;
+
+    player_seat(&players[0], &players[1], &deck);
+    player_deal_cards(&players[0], &deck, RULES_HAND);
+    player_deal_cards(&players[1], &deck, RULES_HAND);
+
+    sim_result_t result = {0};
+    int          playing = 0, streak = 0;
+    for (;;) {
+        result.turns++;
+        turn_result_t turn = play_turn(
+            &players[playing],
+            &players[!playing],
+            &deck,
+            &players[0],
+            &players[1]);
+
+        if (result.first_book == 0 &&
+            players[playing].books[0] != RANK_NULL)
+            result.first_book = result.turns;
+
+        if (turn == TURN_WON) break;
+        if (turn == TURN_EXTRA) {
+            if (++streak > result.streak) result.streak = streak;
+        } else {
+            streak = 0;
+            playing = !playing;
+        }
+    }
+
+    result.winner = playing;
+    for (range(seat, 0, 2, 1)) {
+        result.books[seat] = count_books(&players[seat]);
+        result.booked[seat] = player_booked_slots(&players[seat]);
+    }
+
+    player_cleanup(&players[0]);
+    player_cleanup(&players[1]);
+    return result;
+}
+
+double sim_now() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ts.tv_sec + ts.tv_nsec / 1e9;
+}
+
+uint64_t sim_now_ns() {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + ts.tv_nsec;
+}
+
+int sim_threads() {
+    long count = sysconf(_SC_NPROCESSORS_ONLN);
+    return count > 0 ? (int)count : 1;
+}
+
+// open both strategies, or list the ones there are
+static err_t open_both(const char* const specs[2], strategy_t opened[2]) {
+    for (range(idx, 0, 2, 1)) {
+        if (!strategy_open(specs[idx], &opened[idx])) {
+            fprintf(stderr, "unknown strategy '%s', try:\n", specs[idx]);
+            strategy_list(stderr);
+            if (idx == 1) strategy_close(&opened[0]);
+            return ERROR;
+        }
+    }
+    return SUCCESS;
+}
+
+int sim_replay(
+    const char* const specs[2],
+    uint64_t          seed,
+    uint64_t          game  //
+) {
+    strategy_t opened[2];
+    if (!open_both(specs, opened)) return 1;
+
+    const strategy_t* seats[2] = {&opened[0], &opened[1]};
+    game_out = stdout;
+    sim_result_t result = sim_play(seats, seed, game);
+    game_out = NULL;
+
+    printf(
+        "\ngame %llu of run %llu: %s (seat %i) won, %i books to %i in %i "
+        "turns\n",
+        (unsigned long long)game,
+        (unsigned long long)seed,
+        specs[result.winner],
+        result.winner,
+        result.books[result.winner],
+        result.books[!result.winner],
+        result.turns);
+
+    strategy_close(&opened[0]);
+    strategy_close(&opened[1]);
+    return 0;
+}
+
+typedef struct {
+    const char* const* specs;
+    uint64_t           seed;
+    dealer_t*          dealer;
+    sim_result_t*      results;  // by game number
+} check_t;
+
+static void* check_worker(void* arg) {
+    check_t*   check = arg;
+    strategy_t a, b;
+    if (!strategy_open(check->specs[0], &a) ||
+        !strategy_open(check->specs[1], &b))
+        ohcrap("unknown strategy");
+
+    // odd games swap the seats
+    const strategy_t* seats[2][2] = {{&a, &b}, {&b, &a}};
+
+    deal_t deal;
+    while (dealer_pop(check->dealer, &deal))
+        check->results[deal.game] = sim_play_dealt(
+            seats[deal.game & 1], check->seed, deal.game, &deal.deck);
+
+    strategy_close(&a);
+    strategy_close(&b);
+    endgame_release();
+    return NULL;
+}
+
+// FNV-1a over the results in game order
+static uint64_t results_hash(const sim_result_t* results, long games) {
+    uint64_t             hash = 0xcbf29ce484222325ull;
+    const unsigned char* bytes = (const unsigned char*)results;
+    for (long idx = 0; idx < games * (long)sizeof(sim_result_t); idx++)
+        hash = (hash ^ bytes[idx]) * 0x100000001b3ull;
+    return hash;
+}
+
+int sim_check_threads(
+    const char* const specs[2],
+    long              games,
+    uint64_t          seed  //
+) {
+    strategy_t opened[2];
+    if (!open_both(specs, opened)) return 1;
+    if (games <= 0) ohcrap("the number of games must be positive");
+    if (!rng_self_check()) {
+        fprintf(stderr, "the rng doesn't match the Philox reference\n");
+        return 1;
+    }
+
+    // zeroed so padding bytes can't differ between runs
+    sim_result_t* first = calloc(games, sizeof(sim_result_t));
+    sim_result_t* again = calloc(games, sizeof(sim_result_t));
+    int           thread_counts[] = {1, 2, 3, 8};
+    int           failed = 0;
+    uint64_t      expected = 0;
+
+    for (range(run, 0, 4, 1)) {
+        int      threads = thread_counts[run];
+        check_t  check = {specs, seed, dealer_start(seed, games), again};
+        pthread_t tids[threads];
+
+        memset(again, 0, games * sizeof(sim_result_t));
+        for (range(idx, 0, threads, 1))
+            pthread_create(&tids[idx], NULL, &check_worker, &check);
+        for (range(idx, 0, threads, 1)) pthread_join(tids[idx], NULL);
+        dealer_close(check.dealer);
+
+        long seat0_wins = 0;
+        for (long game = 0; game < games; game++)
+            seat0_wins += again[game].winner == 0;
+
+        uint64_t hash = results_hash(again, games);
+        if (run == 0) {
+            expected = hash;
+            memcpy(first, again, games * sizeof(sim_result_t));
+        }
+        bool same = memcmp(first, again, games * sizeof(sim_result_t)) == 0;
+        failed += !same;
+        printf(
+            "%i threads: %li games, seat 0 won %li, results %016llx %s\n",
+            threads,
+            games,
+            seat0_wins,
+            (unsigned long long)hash,
+            same && hash == expected ? "ok" : "DIFFERENT");
+    }
+
+    // any game can be replayed on its own, without the dealer or the
+    // games before it
+    const strategy_t* seats[2][2] = {
+        {&opened[0], &opened[1]},
+        {&opened[1], &opened[0]},
+    };
+
+    long step = games / 64 > 0 ? games / 64 : 1, replayed = 0, matched = 0;
+    for (long game = games - 1; game >= 0; game -= step, replayed++) {
+        sim_result_t alone = sim_play(seats[game & 1], seed, game);
+        matched += memcmp(&alone, &first[game], sizeof(sim_result_t)) == 0;
+    }
+    strategy_close(&opened[0]);
+    strategy_close(&opened[1]);
+    failed += matched != replayed;
+    printf(
+        "replayed %li games on their own: %li matched %s\n",
+        replayed,
+        matched,
+        matched == replayed ? "ok" : "DIFFERENT");
+
+    free(first);
+    free(again);
+    return failed != 0;
+}
@@ -0,0 +1,106 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "gofish.h"
+#include "strategy.h"
+
+/**
+ * @brief how a headless game went
+ */
+typedef struct {
+    uint8_t  winner;      // seat of the winner, seat 0 moves first
+    uint8_t  books[2];    // per seat
+    uint16_t turns;       // calls to play_turn
+    // per seat, bit r is set if rank slot r is booked by that seat
+    uint16_t booked[2];
+    uint16_t first_book;  // the turn the first book was made on
+    uint8_t  streak;      // the most TURN_EXTRAs in a row
+} sim_result_t;
+
+// which of a game's rng streams each random thing draws from
+#define SIM_STREAM_DECK 0
+#define SIM_STREAM_SEAT 1  // + the seat index
+
+/**
+ * @brief play one silent game between two strategies
+ *
+ * Everything random in the game (the deck, each seat's rng) is keyed by
+ * the run's seed and the game's number (see rng_keyed), so game `game`
+ * of a run always plays the same way, no matter which thread runs it or
+ * whether the games before it were played at all.
+ */
+sim_result_t sim_play(
+    const strategy_t* const seats[2],
+    uint64_t                seed,
+    uint64_t                game);
+
+/**
+ * @brief sim_play with the deck already dealt by sim_deal, the deck is
+ * copied so it can be played again (e.g. with the seats swapped)
+ */
+sim_result_t sim_play_dealt(
+    const strategy_t* const seats[2],
+    uint64_t                seed,
+    uint64_t                game,
+    const deck_t* const     deck);
+
+/**
+ * @brief shuffle the decks of consecutive games of a run
+ *
+ * @param decks `count` decks to (re)initialize and shuffle, for games
+ * first .. first + count - 1
+ */
+void sim_deal(deck_t* const decks, uint64_t seed, uint64_t first, int count);
+
+/**
+ * @brief replay one game of a run with the narration on stdout, A in
+ * seat 0
+ *
+ * @return int process exit code
+ */
+int sim_replay(const char* const specs[2], uint64_t seed, uint64_t game);
+
+/**
+ * @brief play `games` games of a run on 1 thread and on several, and
+ * check every game's result comes out bit for bit the same (and the
+ * same as replaying single games with sim_play)
+ *
+ * @return int process exit code, 1 if any run differs
+ */
+int sim_check_threads(const char* const specs[2], long games, uint64_t seed);
+
+/**
+ * @brief how many worker threads to run by default, one per core
+ */
+int sim_threads();
+
+/**
+ * @brief seconds on the monotonic clock, for timing runs
+ */
+double sim_now();
+
+/**
+ * @brief nanoseconds on the same clock, for deadlines and short waits
+ */
+uint64_t sim_now_ns();
@@ -0,0 +1,535 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <libgen.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "simulate.h"
+#include "lockstep.h"
+#include "endgame.h"
+#include "metrics.h"
+
+#define CHECKPOINT_MAGIC   "GOFISHCK"
+#define CHECKPOINT_VERSION 2
+#define SPEC_MAX           256  // longest strategy spec a checkpoint holds
+
+typedef struct {
+    const char* specs[2];
+    long        games;
+    uint64_t    seed;
+    int         threads;
+    bool        json;
+    bool        lockstep;    // both strategies are lockstep kinds
+    const char* checkpoint;  // nullable, where to save progress
+    double      every;       // seconds between checkpoints
+    const char* resume;      // nullable, the checkpoint to resume
+    int         shard;       // play the shard'th of `shards` parts
+    int         shards;
+    const char* metrics;  // nullable, where to serve live metrics
+} options_t;
+
+/**
+ * a run's progress on disk: everything needed to carry on, the stats of
+ * chunks first_chunk .. next_chunk - 1 and nothing else
+ *
+ * A shard's finished checkpoint (next_chunk == end_chunk) is its result
+ * file, see simulate_merge.
+ */
+typedef struct {
+    char     magic[8];
+    uint32_t version;
+    uint32_t _reserved;
+    uint64_t seed;
+    int64_t  games;        // in the whole run, not just this shard
+    int64_t  first_chunk;  // the chunks this process plays
+    int64_t  end_chunk;
+    int64_t  next_chunk;
+    char     specs[2][SPEC_MAX];
+    stats_t  stats;
+    uint64_t checksum;  // FNV-1a of everything above
+} checkpoint_t;
+
+// a chunk being played, workers fill them and the main thread folds
+// them into the total in chunk order
+typedef struct {
+    _Atomic long chunk;  // the chunk this slot is for
+    _Atomic bool ready;  // its stats are done
+    stats_t      stats;
+} slot_t;
+
+typedef struct {
+    const options_t* options;
+    long             end_chunk;  // play the chunks before this
+    _Atomic long     next_chunk;
+    slot_t*          slots;
+    int              window;  // slots, chunks in flight at most
+    metrics_t*       metrics;  // nullable
+    _Atomic int      next_worker;
+} run_t;
+
+static void wait_a_moment() {
+    nanosleep(&(struct timespec){.tv_nsec = 200000}, NULL);
+}
+
+static void* work(void* arg) {
+    run_t*           run = arg;
+    const options_t* options = run->options;
+    int                 worker = atomic_fetch_add(&run->next_worker, 1);
+    metrics_counters_t* counters =
+        run->metrics != NULL ? metrics_counters(run->metrics, worker)
+                             : NULL;
+
+    lockstep_kind_t kinds[2];
+    strategy_t      opened[2];
+    for (range(idx, 0, 2, 1)) {
+        if (options->lockstep)
+            lockstep_kind(options->specs[idx], &kinds[idx]);
+        else if (!strategy_open(options->specs[idx], &opened[idx]))
+            ohcrap("unknown strategy");
+    }
+    const strategy_t* seats[2][2] = {
+        {&opened[0], &opened[1]},
+        {&opened[1], &opened[0]},
+    };
+
+    sim_result_t results[SIMULATE_CHUNK];
+    for (;;) {
+        long chunk = atomic_fetch_add(&run->next_chunk, 1);
+        if (chunk >= run->end_chunk) break;
+
+        // wait for the main thread to fold the chunk using the slot
+        slot_t* slot = &run->slots[chunk % run->window];
+        while (atomic_load(&slot->chunk) != chunk) wait_a_moment();
+
+        long first = chunk * SIMULATE_CHUNK;
+        long count = options->games - first;
+        if (count > SIMULATE_CHUNK) count = SIMULATE_CHUNK;
+
+        if (options->lockstep) {
+            lockstep_play(kinds, options->seed, first, count, true, results);
+        } else {
+            for (range(idx, 0, count, 1)) {
+                uint64_t game = first + idx;
+                results[idx] =
+                    sim_play(seats[game & 1], options->seed, game);
+            }
+        }
+
+        memset(&slot->stats, 0, sizeof(stats_t));
+        for (range(idx, 0, count, 1))
+            stats_add(&slot->stats, &results[idx], (first + idx) & 1);
+        if (counters != NULL) metrics_add(counters, &slot->stats);
+        atomic_store(&slot->ready, true);
+    }
+
+    if (!options->lockstep) {
+        strategy_close(&opened[0]);
+        strategy_close(&opened[1]);
+    }
+    endgame_release();
+    return NULL;
+}
+
+static long chunks_in(long games) {
+    return (games + SIMULATE_CHUNK - 1) / SIMULATE_CHUNK;
+}
+
+static uint64_t checkpoint_checksum(const checkpoint_t* const point) {
+    uint64_t             hash = 0xcbf29ce484222325ull;
+    const unsigned char* bytes = (const unsigned char*)point;
+    for (range(idx, 0, offsetof(checkpoint_t, checksum), 1))
+        hash = (hash ^ bytes[idx]) * 0x100000001b3ull;
+    return hash;
+}
+
+/**
+ * write the checkpoint next to `path` and rename it into place, so the
+ * file at `path` is always a whole checkpoint, old or new, even if the
+ * process dies part way through
+ */
+static err_t checkpoint_save(
+    const char* const   path,
+    checkpoint_t* const point  //
+) {
+    point->checksum = checkpoint_checksum(point);
+
+    char temp[4096];
+    if (snprintf(temp, sizeof(temp), "%s.tmp", path) >= (int)sizeof(temp))
+        return ERROR;
+
+    int fd = open(temp, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) return ERROR;
+
+    const char* data = (const char*)point;
+    size_t      left = sizeof(checkpoint_t);
+    bool        ok = true;
+    while (ok && left > 0) {
+        ssize_t wrote = write(fd, data, left);
+        if (wrote < 0 && errno == EINTR) continue;
+        ok = wrote > 0;
+        if (ok) {
+            data += wrote;
+            left -= wrote;
+        }
+    }
+
+    // on disk before it replaces the old one, the fd is closed either
+    // way and a half written file doesn't outlive a failure
+    ok = ok && fsync(fd) == 0;
+    ok = close(fd) == 0 && ok;
+    ok = ok && rename(temp, path) == 0;
+    if (!ok) {
+        unlink(temp);
+        return ERROR;
+    }
+
+    // and the rename itself on disk, so the new checkpoint survives a
+    // crash too
+    char dir[sizeof(temp)];
+    strcpy(dir, path);
+    int dir_fd = open(dirname(dir), O_RDONLY | O_DIRECTORY);
+    if (dir_fd < 0) return ERROR;
+    ok = fsync(dir_fd) == 0;
+    close(dir_fd);
+    return ok;
+}
+
+static err_t checkpoint_load(
+    const char* const   path,
+    checkpoint_t* const point  //
+) {
+    FILE* file = fopen(path, "rb");
+    if (file == NULL) return ERROR;
+    bool read_all = fread(point, sizeof(checkpoint_t), 1, file) == 1;
+    fclose(file);
+
+    return read_all &&
+           memcmp(point->magic, CHECKPOINT_MAGIC, sizeof(point->magic)) ==
+               0 &&
+           point->version == CHECKPOINT_VERSION &&
+           point->checksum == checkpoint_checksum(point) &&
+           memchr(point->specs[0], '\0', SPEC_MAX) != NULL &&
+           memchr(point->specs[1], '\0', SPEC_MAX) != NULL &&
+           point->games > 0 && 0 <= point->first_chunk &&
+           point->first_chunk <= point->next_chunk &&
+           point->next_chunk <= point->end_chunk &&
+           point->end_chunk <= chunks_in(point->games);
+}
+
+static void usage() {
+    fprintf(
+        stderr,
+        "usage: --simulate <A> <B> <games> [--seed N] [--threads N] "
+        "[--json]\n"
+        "                  [--checkpoint <file> [--every <secs>]]\n"
+        "                  [--metrics unix:<path> | tcp:<port>]\n"
+        "                  [--shard <i>/<N> --checkpoint <file>]\n"
+        "       --simulate --resume <file> [--threads N] [--json] "
+        "[--every <secs>]\n"
+        "                  [--metrics <addr>]\n");
+}
+
+static err_t parse(int argc, char** argv, options_t* const options) {
+    *options = (options_t){
+        .seed = time(NULL),
+        .threads = sim_threads(),
+        .every = SIMULATE_CHECKPOINT_SECS,
+        .shards = 1,
+    };
+
+    int positional = 0;
+    for (range(idx, 0, argc, 1)) {
+        const char* arg = argv[idx];
+        bool        has_value = idx + 1 < argc;
+
+        if (strcmp(arg, "--json") == 0) {
+            options->json = true;
+        } else if (strcmp(arg, "--seed") == 0 && has_value) {
+            options->seed = strtoull(argv[++idx], NULL, 0);
+        } else if (strcmp(arg, "--threads") == 0 && has_value) {
+            options->threads = atoi(argv[++idx]);
+        } else if (strcmp(arg, "--checkpoint") == 0 && has_value) {
+            options->checkpoint = argv[++idx];
+        } else if (strcmp(arg, "--every") == 0 && has_value) {
+            options->every = atof(argv[++idx]);
+        } else if (strcmp(arg, "--metrics") == 0 && has_value) {
+            options->metrics = argv[++idx];
+        } else if (strcmp(arg, "--resume") == 0 && has_value) {
+            options->resume = argv[++idx];
+        } else if (strcmp(arg, "--shard") == 0 && has_value) {
+            char end;
+            if (sscanf(
+                    argv[++idx],
+                    "%i/%i%c",
+                    &options->shard,
+                    &options->shards,
+                    &end) != 2 ||
+                options->shards < 1 || options->shard < 0 ||
+                options->shard >= options->shards)
+                return ERROR;
+        } else if (arg[0] == '-' && arg[1] == '-') {
+            return ERROR;
+        } else if (positional < 2) {
+            options->specs[positional++] = arg;
+        } else if (positional == 2) {
+            options->games = atol(arg);
+            positional++;
+        } else {
+            return ERROR;
+        }
+    }
+
+    // a resumed run's strategies, games, seed and shard come from the
+    // file
+    if (options->resume != NULL) {
+        if (options->checkpoint == NULL)
+            options->checkpoint = options->resume;
+        return positional == 0 && options->threads > 0 &&
+               options->shards == 1;
+    }
+
+    // a shard's results are only any use written down
+    if (options->shards > 1 && options->checkpoint == NULL) return ERROR;
+    return positional == 3 && options->games > 0 && options->threads > 0;
+}
+
+int simulate_main(int argc, char** argv) {
+    options_t options;
+    if (!parse(argc, argv, &options)) {
+        usage();
+        return 1;
+    }
+
+    // where to start, and what's been counted so far
+    checkpoint_t* point = calloc(1, sizeof(checkpoint_t));
+    if (options.resume != NULL) {
+        if (!checkpoint_load(options.resume, point)) {
+            fprintf(
+                stderr, "'%s' isn't a usable checkpoint\n", options.resume);
+            free(point);
+            return 1;
+        }
+        options.specs[0] = point->specs[0];
+        options.specs[1] = point->specs[1];
+        options.games = point->games;
+        options.seed = point->seed;
+    } else {
+        memcpy(point->magic, CHECKPOINT_MAGIC, sizeof(point->magic));
+        point->version = CHECKPOINT_VERSION;
+        point->seed = options.seed;
+        point->games = options.games;
+
+        // shard i gets the i'th of N runs of whole chunks
+        long chunks = chunks_in(options.games);
+        point->first_chunk = chunks * options.shard / options.shards;
+        point->end_chunk = chunks * (options.shard + 1) / options.shards;
+        point->next_chunk = point->first_chunk;
+        for (range(idx, 0, 2, 1)) {
+            if (strlen(options.specs[idx]) >= SPEC_MAX)
+                ohcrap("strategy spec too long to checkpoint");
+            strcpy(point->specs[idx], options.specs[idx]);
+        }
+    }
+
+    options.lockstep = true;
+    for (range(idx, 0, 2, 1)) {
+        lockstep_kind_t kind;
+        strategy_t      probe;
+        if (!lockstep_kind(options.specs[idx], &kind))
+            options.lockstep = false;
+        if (!strategy_open(options.specs[idx], &probe)) {
+            fprintf(
+                stderr, "unknown strategy '%s', try:\n", options.specs[idx]);
+            strategy_list(stderr);
+            free(point);
+            return 1;
+        }
+        strategy_close(&probe);
+    }
+
+    run_t run = {
+        .options = &options,
+        .end_chunk = point->end_chunk,
+        .window = 4 * options.threads,
+    };
+    long start_chunk = point->next_chunk;
+    atomic_init(&run.next_chunk, start_chunk);
+    run.slots = calloc(run.window, sizeof(slot_t));
+    atomic_init(&run.next_worker, 0);
+    for (long chunk = start_chunk; chunk < start_chunk + run.window; chunk++)
+        atomic_init(&run.slots[chunk % run.window].chunk, chunk);
+
+    long end_game = run.end_chunk * SIMULATE_CHUNK;
+    if (end_game > options.games) end_game = options.games;
+    long played = end_game - start_chunk * SIMULATE_CHUNK;
+    if (played < 0) played = 0;
+
+    if (options.metrics != NULL)
+        run.metrics = metrics_start(
+            options.metrics,
+            options.threads,
+            options.specs,
+            played,
+            point->stats.games);
+
+    pthread_t tids[options.threads];
+    double    start = sim_now();
+    double    last_saved = start;
+    for (range(idx, 0, options.threads, 1))
+        pthread_create(&tids[idx], NULL, &work, &run);
+
+    // fold chunks in order, so a checkpoint is always a whole prefix
+    for (long chunk = start_chunk; chunk < run.end_chunk; chunk++) {
+        slot_t* slot = &run.slots[chunk % run.window];
+        while (!atomic_load(&slot->ready)) wait_a_moment();
+
+        stats_merge(&point->stats, &slot->stats);
+        atomic_store(&slot->ready, false);
+        atomic_store(&slot->chunk, chunk + run.window);
+        point->next_chunk = chunk + 1;
+
+        if (options.checkpoint != NULL &&
+            sim_now() - last_saved >= options.every) {
+            if (!checkpoint_save(options.checkpoint, point))
+                fprintf(stderr, "couldn't save a checkpoint\n");
+            last_saved = sim_now();
+        }
+    }
+    for (range(idx, 0, options.threads, 1)) pthread_join(tids[idx], NULL);
+    double secs = sim_now() - start;
+    if (run.metrics != NULL) metrics_stop(run.metrics);
+
+    if (options.checkpoint != NULL &&
+        !checkpoint_save(options.checkpoint, point))
+        fprintf(stderr, "couldn't save a checkpoint\n");
+
+    if (options.json) {
+        stats_print_json(&point->stats, options.specs, options.seed, stdout);
+    } else {
+        stats_print_table(&point->stats, options.specs, stdout);
+        printf(
+            "\n%.3fs on %i threads (%s), %.0f games/sec, seed %llu\n",
+            secs,
+            options.threads,
+            options.lockstep ? "lockstep engine" : "play_turn",
+            played / secs,
+            (unsigned long long)options.seed);
+    }
+
+    free(run.slots);
+    free(point);
+    return 0;
+}
+
+static int by_first_chunk(const void* a, const void* b) {
+    const checkpoint_t* x = a;
+    const checkpoint_t* y = b;
+    if (x->first_chunk != y->first_chunk)
+        return x->first_chunk < y->first_chunk ? -1 : 1;
+    return (x->end_chunk > y->end_chunk) - (x->end_chunk < y->end_chunk);
+}
+
+int simulate_merge(int argc, char** argv) {
+    bool json = false;
+    int  count = 0;
+    for (range(idx, 0, argc, 1)) {
+        if (strcmp(argv[idx], "--json") == 0)
+            json = true;
+        else
+            count++;
+    }
+    if (count == 0) {
+        fprintf(stderr, "usage: --merge <file>... [--json]\n");
+        return 1;
+    }
+
+    checkpoint_t* shards = calloc(count, sizeof(checkpoint_t));
+    int           loaded = 0;
+    for (range(idx, 0, argc, 1)) {
+        const char* path = argv[idx];
+        if (strcmp(path, "--json") == 0) continue;
+
+        checkpoint_t* shard = &shards[loaded++];
+        const char*   problem = NULL;
+        if (!checkpoint_load(path, shard))
+            problem = "isn't a usable result file";
+        else if (shard->next_chunk != shard->end_chunk)
+            problem = "is of an unfinished shard, --resume it first";
+        else if (
+            shard->seed != shards[0].seed ||
+            shard->games != shards[0].games ||
+            strcmp(shard->specs[0], shards[0].specs[0]) != 0 ||
+            strcmp(shard->specs[1], shards[0].specs[1]) != 0)
+            problem = "is from a different run";
+
+        if (problem != NULL) {
+            fprintf(stderr, "'%s' %s\n", path, problem);
+            free(shards);
+            return 1;
+        }
+    }
+
+    // between them the shards have to cover every chunk exactly once
+    qsort(shards, count, sizeof(checkpoint_t), &by_first_chunk);
+    stats_t total = {0};
+    long    covered = 0;
+    int     merged = 0;
+    while (merged < count && shards[merged].first_chunk == covered) {
+        stats_merge(&total, &shards[merged].stats);
+        covered = shards[merged++].end_chunk;
+    }
+
+    int status = 0;
+    if (merged != count || covered != chunks_in(shards[0].games)) {
+        bool doubled =
+            merged < count && shards[merged].first_chunk < covered;
+        fprintf(
+            stderr,
+            "the shards don't cover the run exactly once, game %li is %s\n",
+            (doubled ? shards[merged].first_chunk : covered) *
+                SIMULATE_CHUNK,
+            doubled ? "in two of them" : "missing");
+        status = 1;
+    } else {
+        const char* specs[2] = {shards[0].specs[0], shards[0].specs[1]};
+        if (json) {
+            stats_print_json(&total, specs, shards[0].seed, stdout);
+        } else {
+            stats_print_table(&total, specs, stdout);
+            printf(
+                "\nmerged %i shards, seed %llu\n",
+                count,
+                (unsigned long long)shards[0].seed);
+        }
+    }
+
+    free(shards);
+    return status;
+}
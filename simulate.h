@@ -0,0 +1,77 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "stats.h"
+
+/** === [ Batch simulation ] ===
+ *
+ *   --simulate <A> <B> <games> [--seed N] [--threads N] [--json]
+ *              [--checkpoint <file> [--every <secs>]]
+ *              [--shard <i>/<N> --checkpoint <file>]
+ *              [--metrics unix:<path> | tcp:<port>]
+ *   --simulate --resume <file> [--threads N] [--json] [--every <secs>]
+ *   --merge <file>... [--json]
+ *
+ * Plays games 0 .. games-1 of a run between A and B (odd games swap
+ * the seats) on every core and prints their statistics, see stats.h.
+ * When both strategies are ones the lockstep engine knows the games are
+ * played on it, otherwise through sim_play; the results are the same.
+ *
+ * Workers play chunks of games and the main thread folds their stats
+ * into the total in chunk order, so the total is always exactly the
+ * first N chunks. With --checkpoint that total (and the run's seed,
+ * strategies and size) is saved every so often by writing a new file
+ * and renaming it over the old one, so a killed run leaves a whole
+ * checkpoint behind. --resume carries on from the next chunk; since
+ * every game is keyed by its number (see rng_keyed) the finished run's
+ * results are bit for bit those of a run that was never stopped.
+ *
+ * --shard i/N plays only the i'th of N equal runs of chunks, so N
+ * processes (on as many machines) given the same seed split a run
+ * between them with nothing to coordinate. A shard's final checkpoint
+ * is its result file, and --merge adds up the files of all N into
+ * exactly the statistics one process playing every game would print.
+ *
+ * --metrics serves the run's progress while it plays, see metrics.h.
+ */
+
+#define SIMULATE_CHUNK           1024  // games a worker takes at a time
+#define SIMULATE_CHECKPOINT_SECS 60    // the default checkpoint period
+
+/**
+ * @brief run `--simulate`, argv starts at the first argument after it
+ *
+ * @return int process exit code
+ */
+int simulate_main(int argc, char** argv);
+
+/**
+ * @brief run `--merge`, combine the result files of a sharded run
+ *
+ * Fails unless the files are all finished shards of the same run that
+ * between them cover every game exactly once.
+ *
+ * @return int process exit code
+ */
+int simulate_merge(int argc, char** argv);
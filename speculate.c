@@ -0,0 +1,195 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <string.h>
+
+#include "speculate.h"
+#include "endgame.h"
+
+// a copy of a player, its own hand and all, reading ranks differently
+static player_t* copy_player(
+    const player_t* const from,
+    rank_t (*read_rank)(player_t*)  //
+) {
+    player_t  copy = player_init(from->name, false, read_rank);
+    player_t* into = malloc(sizeof(player_t));
+    copy.ctx = from->ctx;
+    copy.rng = from->rng;
+    copy.seen = from->seen;
+    memcpy(copy.books, from->books, sizeof(copy.books));
+    for (hand_node_t node = from->hand.head; node; node = node->next)
+        hand_add_card_idx(&copy.hand, node->card);
+    memcpy(into, &copy, sizeof(player_t));
+    return into;
+}
+
+static void free_player(player_t* const player) {
+    player_cleanup(player);
+    free(player);
+}
+
+static speculate_at_t position_of(const player_t* const compy) {
+    const player_t* other = compy->opponent;
+    return (speculate_at_t){
+        .hands = {hand_mask(&compy->hand), hand_mask(&other->hand)},
+        .seen = {compy->seen, other->seen},
+        .booked = {player_booked_slots(compy), player_booked_slots(other)},
+        .remaining = compy->deck->remaining,
+        .rng = compy->rng,
+    };
+}
+
+static bool same_position(const speculate_at_t* a, const speculate_at_t* b) {
+    return a->hands[0] == b->hands[0] && a->hands[1] == b->hands[1] &&
+           memcmp(&a->seen, &b->seen, sizeof(a->seen)) == 0 &&
+           a->booked[0] == b->booked[0] && a->booked[1] == b->booked[1] &&
+           a->remaining == b->remaining &&
+           memcmp(a->rng.key, b->rng.key, sizeof(a->rng.key)) == 0 &&
+           memcmp(a->rng.counter, b->rng.counter, sizeof(a->rng.counter)) ==
+               0 &&
+           a->rng.used == b->rng.used;
+}
+
+// the user's side of a speculated turn, the rank is in ctx
+static rank_t fixed_read_rank(player_t* player) {
+    return *(const rank_t*)player->ctx;
+}
+
+// the compy's side of a speculated turn, deciding as it really would
+// and keeping the answer
+static rank_t answering_read_rank(player_t* player) {
+    speculation_t* spec = player->ctx;
+    speculate_at_t at = position_of(player);
+    rank_t         rank = spec->decide(player);
+
+    int idx = atomic_load_explicit(&spec->count, memory_order_relaxed);
+    if (idx < SPECULATE_ANSWERS) {
+        spec->answers[idx].at = at;
+        spec->answers[idx].rank = rank;
+        spec->answers[idx].rng = player->rng;
+        atomic_store_explicit(&spec->count, idx + 1, memory_order_release);
+    }
+    return rank;
+}
+
+static void* speculate(void* arg) {
+    speculation_t* spec = arg;
+    card_mask_t    held = hand_mask(&spec->user->hand);
+
+    for (range(slot, 0, 13, 1)) {
+        if (atomic_load(&spec->cancel)) break;
+        if (!(held & card_mask_rank(slot))) continue;
+
+        rank_t    ask = slot + RANK_2;
+        player_t* user = copy_player(spec->user, &fixed_read_rank);
+        player_t* compy = copy_player(spec->compy, &answering_read_rank);
+        deck_t    deck = spec->deck;
+        user->ctx = &ask;
+        player_seat(user, compy, &deck);
+
+        // if the ask hands the turn over, the compy's turns up to the
+        // user's next prompt
+        if (play_turn(user, compy, &deck, user, compy) == TURN_NEXT)
+            while (!atomic_load(&spec->cancel) &&
+                   atomic_load(&spec->count) < SPECULATE_ANSWERS &&
+                   play_turn(compy, user, &deck, user, compy) == TURN_EXTRA)
+                continue;
+
+        free_player(user);
+        free_player(compy);
+    }
+
+    endgame_release();
+    return NULL;
+}
+
+// stop the thread, wait for it to notice and drop its copies
+static void settle(speculation_t* const spec) {
+    if (!spec->running) return;
+    atomic_store(&spec->cancel, true);
+    pthread_join(spec->thread, NULL);
+    free_player(spec->user);
+    free_player(spec->compy);
+    spec->running = false;
+}
+
+speculation_t speculate_init(rank_t (*decide)(player_t*)) {
+    speculation_t spec = {.decide = decide};
+    atomic_init(&spec.cancel, false);
+    atomic_init(&spec.count, 0);
+    return spec;
+}
+
+rank_t speculate_query_for_rank(player_t* player) {
+    speculation_t* spec = player->ctx;
+    settle(spec);
+
+    // the copies are made here, before the prompt, so the thread never
+    // sees the real table
+    spec->user = copy_player(player, player->read_rank);
+    spec->compy = copy_player(player->opponent, spec->decide);
+    spec->deck = *player->deck;
+    atomic_store(&spec->cancel, false);
+    atomic_store(&spec->count, 0);
+    spec->running =
+        pthread_create(&spec->thread, NULL, &speculate, spec) == 0;
+    if (!spec->running) {
+        free_player(spec->user);
+        free_player(spec->compy);
+    }
+
+    return player_query_for_rank(player);
+}
+
+rank_t speculate_compy_turn(player_t* player) {
+    speculation_t* spec = player->ctx;
+    // no joining here: the thread stops at its next check, and whatever
+    // it has stored by now is all this turn gets
+    atomic_store(&spec->cancel, true);
+    int count = atomic_load_explicit(&spec->count, memory_order_acquire);
+
+    speculate_at_t at = position_of(player);
+    for (range(idx, 0, count, 1)) {
+        if (!same_position(&spec->answers[idx].at, &at)) continue;
+        spec->hits++;
+        rank_t rank = spec->answers[idx].rank;
+        player->rng = spec->answers[idx].rng;
+        game_printf(
+            "%s is looking for Rank: " ESC_CYN "%s" ESC_RST "\n",
+            player->name,
+            rank_as_str(rank));
+        return rank;
+    }
+
+    spec->misses++;
+    return spec->decide(player);
+}
+
+void speculate_finish(speculation_t* const spec) {
+    settle(spec);
+#ifdef GO_DEBUG
+    printf(
+        "speculation: %li compy turns answered ahead, %li not\n",
+        spec->hits,
+        spec->misses);
+#endif
+}
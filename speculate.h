@@ -0,0 +1,112 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "gofish.h"
+
+/** === [ Speculation ] ===
+ *
+ * In the interactive game the compy only starts deciding once the
+ * user's turn is over, and the user's turn spends nearly all its time
+ * waiting in fgets. The engine knows everything the user's ask could
+ * lead to: there's one ask per rank in the user's hand, and each plays
+ * out one way (the compy's cards and the top of the deck are fixed).
+ * So while the prompt waits, a background thread plays every one of
+ * those asks on copies of the table and, for each that hands the turn
+ * to the compy, works out the compy's answer, and its answers for any
+ * extra turns it earns after that.
+ *
+ * When the compy's turn comes the thread is told to stop, and the
+ * answer for the position it's actually in is taken as is if it's
+ * already stored; if not, the compy decides itself rather than wait
+ * for the thread. The thread checks between asks and between compy
+ * turns, and is joined before the next prompt. Each answer is stored with
+ * everything the compy's decision can depend on (both hands, what's
+ * been seen of them, the books, the deck size, its rng) and only used
+ * if that matches exactly, so a wrong guess costs nothing but the work
+ * and a right one leaves the game exactly as deciding then would. The
+ * thread only ever touches its own copies, and game_out is per thread
+ * so it plays silently.
+ */
+
+#define SPECULATE_ANSWERS 64  // compy turns worked out per prompt
+
+/**
+ * @brief everything a compy's decision can depend on
+ */
+typedef struct {
+    card_mask_t hands[2];  // the compy's, its opponent's
+    belief_t    seen[2];
+    uint16_t    booked[2];  // rank slots each has booked
+    uint8_t     remaining;  // in the deck
+    rng_t       rng;        // the compy's, for strategies that use it
+} speculate_at_t;
+
+/**
+ * @brief the ctx of both players of an interactive game
+ */
+typedef struct {
+    // the compy's real read_rank
+    rank_t (*decide)(player_t*);
+    pthread_t    thread;
+    bool         running;
+    _Atomic bool cancel;  // set to stop the thread at its next check
+    // copies of the table as the user asks, the thread's while running
+    player_t* user;
+    player_t* compy;
+    deck_t    deck;
+    // answers stored, each filled in before count is raised past it
+    _Atomic int count;
+    struct {
+        speculate_at_t at;
+        rank_t         rank;
+        rng_t          rng;  // the compy's, after deciding
+    } answers[SPECULATE_ANSWERS];
+    long hits, misses;  // compy turns answered ahead of time or not
+} speculation_t;
+
+/**
+ * @brief nothing speculated yet, the compy deciding with `decide`
+ */
+speculation_t speculate_init(rank_t (*decide)(player_t*));
+
+/**
+ * @brief read_rank for the user, the prompt with speculation started
+ * behind it
+ */
+rank_t speculate_query_for_rank(player_t* player);
+
+/**
+ * @brief read_rank for the compy, the speculated answer if there is
+ * one for this position, else `decide`
+ */
+rank_t speculate_compy_turn(player_t* player);
+
+/**
+ * @brief stop anything still running and free its copies, at the end
+ * of a game
+ */
+void speculate_finish(speculation_t* const);
@@ -0,0 +1,242 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <string.h>
+
+#include "stats.h"
+
+#define QUANTILES 7
+static const double quantiles[QUANTILES] = {
+    0.05, 0.25, 0.5, 0.75, 0.95, 0.99, 1.0};
+static const char* const quantile_names[QUANTILES] = {
+    "p5", "p25", "p50", "p75", "p95", "p99", "max"};
+
+static inline int capped(int value, int cap) {
+    return value < cap ? value : cap;
+}
+
+void stats_add(
+    stats_t* const            stats,
+    const sim_result_t* const result,
+    bool                      swapped  //
+) {
+    stats->games++;
+    stats->seat0_wins += result->winner == 0;
+    stats->wins[result->winner ^ swapped]++;
+
+    for (range(seat, 0, 2, 1)) {
+        int who = seat ^ swapped;
+        stats->books[who][capped(result->books[seat], RULES_TO_WIN)]++;
+        for (range(slot, 0, 13, 1))
+            stats->rank_books[who][slot] +=
+                (result->booked[seat] >> slot) & 1;
+    }
+
+    stats->turns[capped(result->turns, STATS_TURNS)]++;
+    stats->first_book[capped(result->first_book, STATS_TURNS)]++;
+    stats->streak[capped(result->streak, STATS_STREAK)]++;
+}
+
+void stats_merge(stats_t* const into, const stats_t* const from) {
+    // every field is a uint64_t count
+    uint64_t*       dest = (uint64_t*)into;
+    const uint64_t* src = (const uint64_t*)from;
+    for (range(idx, 0, sizeof(stats_t) / sizeof(uint64_t), 1))
+        dest[idx] += src[idx];
+}
+
+int stats_quantile(const uint64_t* const hist, int bins, double q) {
+    uint64_t total = 0;
+    for (range(idx, 0, bins, 1)) total += hist[idx];
+    if (total == 0) return 0;
+
+    // the rank of the quantile, at least 1 so q = 0 is the minimum
+    uint64_t want = (uint64_t)(q * total + 0.5);
+    if (want == 0) want = 1;
+
+    uint64_t seen = 0;
+    for (range(idx, 0, bins, 1)) {
+        seen += hist[idx];
+        if (seen >= want) return idx;
+    }
+    return bins - 1;
+}
+
+static double hist_mean(const uint64_t* const hist, int bins) {
+    uint64_t total = 0, sum = 0;
+    for (range(idx, 0, bins, 1)) {
+        total += hist[idx];
+        sum += hist[idx] * idx;
+    }
+    return total != 0 ? (double)sum / total : 0;
+}
+
+static void table_row(
+    FILE* const           out,
+    const char* const     label,
+    const uint64_t* const hist,
+    int                   bins  //
+) {
+    fprintf(out, "%-24s %6.1f", label, hist_mean(hist, bins));
+    for (range(idx, 0, QUANTILES, 1))
+        fprintf(out, " %5i", stats_quantile(hist, bins, quantiles[idx]));
+    fprintf(out, "\n");
+}
+
+void stats_print_table(
+    const stats_t* const stats,
+    const char* const    names[2],
+    FILE* const          out  //
+) {
+    double games = stats->games != 0 ? stats->games : 1;
+
+    fprintf(out, "%-24s %li\n", "games", (long)stats->games);
+    for (range(who, 0, 2, 1))
+        fprintf(
+            out,
+            "%-24s %li (%.2f%%)\n",
+            names[who],
+            (long)stats->wins[who],
+            100 * stats->wins[who] / games);
+    fprintf(
+        out,
+        "%-24s %.2f%%\n\n",
+        "won by the first mover",
+        100 * stats->seat0_wins / games);
+
+    fprintf(out, "%-24s %6s", "", "mean");
+    for (range(idx, 0, QUANTILES, 1))
+        fprintf(out, " %5s", quantile_names[idx]);
+    fprintf(out, "\n");
+
+    table_row(out, "turns per game", stats->turns, STATS_TURNS + 1);
+    table_row(out, "first book on turn", stats->first_book, STATS_TURNS + 1);
+    table_row(out, "longest extra streak", stats->streak, STATS_STREAK + 1);
+    for (range(who, 0, 2, 1)) {
+        char label[64];
+        snprintf(label, sizeof(label), "books, %s", names[who]);
+        table_row(out, label, stats->books[who], RULES_TO_WIN + 1);
+    }
+
+    fprintf(out, "\nbooks by rank (%% of games)\n%-12s", "");
+    for (range(slot, 0, 13, 1))
+        fprintf(out, " %4s", rank_as_str(slot + RANK_2));
+    fprintf(out, "\n");
+    for (range(who, 0, 2, 1)) {
+        fprintf(out, "%-12.12s", names[who]);
+        for (range(slot, 0, 13, 1))
+            fprintf(
+                out, " %4.0f", 100 * stats->rank_books[who][slot] / games);
+        fprintf(out, "\n");
+    }
+}
+
+// a JSON string, only escaping what can turn up in a strategy spec
+static void json_string(FILE* const out, const char* str) {
+    fputc('"', out);
+    for (; *str != '\0'; str++) {
+        if (*str == '"' || *str == '\\') fputc('\\', out);
+        if ((unsigned char)*str < 0x20)
+            fprintf(out, "\\u%04x", *str);
+        else
+            fputc(*str, out);
+    }
+    fputc('"', out);
+}
+
+static void json_counts(
+    FILE* const           out,
+    const uint64_t* const counts,
+    int                   length  //
+) {
+    fputc('[', out);
+    for (range(idx, 0, length, 1))
+        fprintf(
+            out,
+            "%s%llu",
+            idx ? "," : "",
+            (unsigned long long)counts[idx]);
+    fputc(']', out);
+}
+
+// a histogram's summary and its counts, up to the last non empty bin
+static void json_hist(
+    FILE* const           out,
+    const char* const     name,
+    const uint64_t* const hist,
+    int                   bins  //
+) {
+    int used = bins;
+    while (used > 0 && hist[used - 1] == 0) used--;
+
+    fprintf(out, "\"%s\":{\"mean\":%.4f", name, hist_mean(hist, bins));
+    for (range(idx, 0, QUANTILES, 1))
+        fprintf(
+            out,
+            ",\"%s\":%i",
+            quantile_names[idx],
+            stats_quantile(hist, bins, quantiles[idx]));
+    fprintf(out, ",\"capped_at\":%i,\"histogram\":", bins - 1);
+    json_counts(out, hist, used);
+    fputc('}', out);
+}
+
+void stats_print_json(
+    const stats_t* const stats,
+    const char* const    names[2],
+    uint64_t             seed,
+    FILE* const          out  //
+) {
+    fprintf(
+        out,
+        "{\"seed\":%llu,\"games\":%llu,\"strategies\":[",
+        (unsigned long long)seed,
+        (unsigned long long)stats->games);
+    json_string(out, names[0]);
+    fputc(',', out);
+    json_string(out, names[1]);
+    fprintf(
+        out,
+        "],\"seat0_wins\":%llu,\"wins\":",
+        (unsigned long long)stats->seat0_wins);
+    json_counts(out, stats->wins, 2);
+
+    fputc(',', out);
+    json_hist(out, "turns", stats->turns, STATS_TURNS + 1);
+    fputc(',', out);
+    json_hist(out, "first_book", stats->first_book, STATS_TURNS + 1);
+    fputc(',', out);
+    json_hist(out, "streak", stats->streak, STATS_STREAK + 1);
+
+    fprintf(out, ",\"books\":[");
+    for (range(who, 0, 2, 1)) {
+        if (who) fputc(',', out);
+        json_counts(out, stats->books[who], RULES_TO_WIN + 1);
+    }
+    fprintf(out, "],\"rank_books\":[");
+    for (range(who, 0, 2, 1)) {
+        if (who) fputc(',', out);
+        json_counts(out, stats->rank_books[who], 13);
+    }
+    fprintf(out, "]}\n");
+}
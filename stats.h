@@ -0,0 +1,98 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include <stdio.h>
+
+#include "sim.h"
+
+/** === [ Statistics ] ===
+ *
+ * Summaries of a batch of games as fixed size integer histograms, so
+ * they take the same memory for a thousand games or a billion, adding a
+ * game is a handful of increments, and two summaries merge by adding
+ * their counts. Each worker keeps its own and they're merged at the
+ * end; since it's all integer counts the merged result doesn't depend
+ * on which worker played which game.
+ *
+ * Everything measured is a small integer (turns, books, streaks), so a
+ * bin per value up to a cap is an exact quantile sketch in that range,
+ * anything past the cap lands in the last bin.
+ */
+
+#define STATS_TURNS  512  // turn numbers from this up share the last bin
+#define STATS_STREAK 64   // likewise for TURN_EXTRA streaks
+
+typedef struct {
+    uint64_t games;
+    uint64_t seat0_wins;  // won by whoever moved first
+    // by strategy (0 is A, 1 is B) rather than seat
+    uint64_t wins[2];
+    // games ending with that many books
+    uint64_t books[2][RULES_TO_WIN + 1];
+    uint64_t rank_books[2][13];  // books made of each rank (2s first)
+    // games by value
+    uint64_t turns[STATS_TURNS + 1];
+    uint64_t first_book[STATS_TURNS + 1];  // 0 if no book was made
+    uint64_t streak[STATS_STREAK + 1];
+} stats_t;
+
+/**
+ * @brief count a game
+ *
+ * @param swapped whether B was in seat 0
+ */
+void stats_add(
+    stats_t* const            stats,
+    const sim_result_t* const result,
+    bool                      swapped);
+
+/**
+ * @brief add everything counted in `from` to `into`
+ */
+void stats_merge(stats_t* const into, const stats_t* const from);
+
+/**
+ * @brief the q-quantile (0-1) of a histogram, the smallest value with
+ * at least q of the counts at or below it
+ */
+int stats_quantile(const uint64_t* const hist, int bins, double q);
+
+/**
+ * @brief print a human readable summary
+ *
+ * @param names the two strategies, A then B
+ */
+void stats_print_table(
+    const stats_t* const stats,
+    const char* const    names[2],
+    FILE* const          out);
+
+/**
+ * @brief print the summary, histograms included, as one JSON object
+ */
+void stats_print_json(
+    const stats_t* const stats,
+    const char* const    names[2],
+    uint64_t             seed,
+    FILE* const          out);
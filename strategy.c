@@ -0,0 +1,137 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "strategy.h"
+#include "bot.h"
+#include "policy.h"
+#include "weights.h"
+
+static rank_t most_read_rank(player_t* player) {
+    bot_obs_t obs;
+    bot_observe(player, &obs);
+    return bot_example_pick(&obs) + RANK_2;
+}
+
+static void* pipe_open(const char* const cmd) { return bot_spawn(cmd); }
+
+static void pipe_close(void* ctx) { bot_close(ctx); }
+
+static void* table_open(const char* const path) { return policy_open(path); }
+
+static void table_close(void* ctx) { policy_close(ctx); }
+
+static void* weights_file_open(const char* const path) {
+    return weights_open(path);
+}
+
+static void weights_file_close(void* ctx) { weights_close(ctx); }
+
+static const strategy_def_t strategies[] = {
+    {
+        .name = "random",
+        .help = "the computer player, asks for a random card in its hand",
+        .read_rank = &play_compy_turn,
+    },
+    {
+        .name = "most",
+        .help = "asks for the rank it holds the most of",
+        .read_rank = &most_read_rank,
+    },
+    {
+        .name = "belief",
+        .help = "asks for the rank the opponent most likely holds",
+        .read_rank = &play_compy_belief_turn,
+    },
+    {
+        .name = "pipe",
+        .help = "pipe:<cmd> an external bot, see bot.h",
+        .takes_arg = true,
+        .read_rank = &bot_read_rank,
+        .open = &pipe_open,
+        .close = &pipe_close,
+    },
+    {
+        .name = "table",
+        .help = "table:<file> a policy table, see --train-policy",
+        .takes_arg = true,
+        .read_rank = &policy_read_rank,
+        .open = &table_open,
+        .close = &table_close,
+    },
+    {
+        .name = "weights",
+        .help = "weights:<file> a weighted heuristic, see --tune",
+        .takes_arg = true,
+        .read_rank = &weights_read_rank,
+        .open = &weights_file_open,
+        .close = &weights_file_close,
+    },
+};
+
+#define STRATEGY_COUNT (sizeof(strategies) / sizeof(strategies[0]))
+
+err_t strategy_open(const char* const spec, strategy_t* const into) {
+    const char* colon = strchr(spec, ':');
+    size_t      name_len = colon != NULL ? (size_t)(colon - spec)
+                                         : strlen(spec);
+
+    for (range(idx, 0, STRATEGY_COUNT, 1)) {
+        const strategy_def_t* def = &strategies[idx];
+        if (strlen(def->name) != name_len ||
+            strncmp(def->name, spec, name_len) != 0)
+            continue;
+        // an argument is required exactly when the strategy takes one
+        if (def->takes_arg != (colon != NULL)) return ERROR;
+
+        into->def = def;
+        into->ctx = def->open != NULL ? def->open(colon + 1) : NULL;
+        return SUCCESS;
+    }
+    return ERROR;
+}
+
+void strategy_close(strategy_t* const strategy) {
+    if (strategy->def->close != NULL) strategy->def->close(strategy->ctx);
+    strategy->ctx = NULL;
+}
+
+player_t strategy_player(
+    const strategy_t* const strategy,
+    const char* const       name  //
+) {
+    player_t player = player_init(name, false, strategy->def->read_rank);
+    player.ctx = strategy->ctx;
+    return player;
+}
+
+void strategy_list(FILE* const out) {
+    for (range(idx, 0, STRATEGY_COUNT, 1))
+        fprintf(
+            out,
+            "  %-8s %s\n",
+            strategies[idx].name,
+            strategies[idx].help);
+}
@@ -0,0 +1,74 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "player.h"
+
+/**
+ * @brief a named way of picking ranks, i.e. something to put in
+ * player_t.read_rank
+ *
+ * Strategies are named on the command line as "name" or "name:arg"
+ * (e.g. "random", "pipe:./my-bot"), see strategy_list.
+ */
+typedef struct {
+    const char* name;
+    const char* help;
+    bool        takes_arg;
+    // what the players using this strategy read ranks with
+    rank_t (*read_rank)(struct _player*);
+    // nullable, makes the player ctx from the spec's argument
+    void* (*open)(const char* const arg);
+    // nullable, releases what open made
+    void (*close)(void* ctx);
+} strategy_def_t;
+
+/**
+ * @brief an opened strategy, one per thread that plays with it
+ */
+typedef struct {
+    const strategy_def_t* def;
+    void*                 ctx;  // nullable
+} strategy_t;
+
+/**
+ * @brief look up and open a strategy from its command line spec
+ *
+ * @return err_t ERROR if there's no such strategy
+ */
+err_t strategy_open(const char* const spec, strategy_t* const into);
+
+/**
+ * @brief release an opened strategy
+ */
+void strategy_close(strategy_t* const);
+
+/**
+ * @brief a fresh player that picks ranks with the strategy
+ */
+player_t strategy_player(const strategy_t* const, const char* const name);
+
+/**
+ * @brief print the strategies that can be named, one per line
+ */
+void strategy_list(FILE* const out);
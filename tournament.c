@@ -0,0 +1,211 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <time.h>
+
+#include "tournament.h"
+#include "endgame.h"
+#include "dealer.h"
+
+typedef struct {
+    _Atomic long finished;  // pairs played so far
+    // pairs in which A won 0, 1, or 2 of the games
+    _Atomic long pairs[3];
+} batch_t;
+
+typedef struct {
+    const char* const* specs;
+    uint64_t           seed;
+    dealer_t*          dealer;  // pair i plays game i's deal
+    long               max_pairs;
+    batch_t*           batches;
+    long               batch_count;
+} tournament_t;
+
+typedef enum {
+    SPRT_CONTINUE,
+    SPRT_A_STRONGER,
+    SPRT_B_STRONGER,
+    SPRT_NO_DIFFERENCE,
+} sprt_t;
+
+static void* worker(void* arg) {
+    tournament_t* t = arg;
+    strategy_t    a, b;
+    if (!strategy_open(t->specs[0], &a) || !strategy_open(t->specs[1], &b))
+        ohcrap("unknown strategy");
+
+    const strategy_t* a_first[2] = {&a, &b};
+    const strategy_t* b_first[2] = {&b, &a};
+
+    // both games of a pair play the same deal
+    deal_t deal;
+    while (dealer_pop(t->dealer, &deal)) {
+        int a_wins =
+            (sim_play_dealt(a_first, t->seed, deal.game, &deal.deck)
+                 .winner == 0) +
+            (sim_play_dealt(b_first, t->seed, deal.game, &deal.deck)
+                 .winner == 1);
+
+        batch_t* batch = &t->batches[deal.game / TOURNAMENT_BATCH];
+        atomic_fetch_add(&batch->pairs[a_wins], 1);
+        atomic_fetch_add(&batch->finished, 1);
+    }
+
+    strategy_close(&a);
+    strategy_close(&b);
+    endgame_release();
+    return NULL;
+}
+
+/**
+ * @brief the log likelihood ratio of mean score s1 against s0, given
+ * the pairs so far (normal approximation)
+ */
+static double llr(double n, double mean, double var, double s0, double s1) {
+    return n * (s1 - s0) * (2 * mean - s0 - s1) / (2 * var);
+}
+
+static sprt_t sprt(const long pairs[3], double* mean_out, double* var_out) {
+    double n = pairs[0] + pairs[1] + pairs[2];
+    double mean = (0.5 * pairs[1] + pairs[2]) / n;
+    double var = (0.25 * pairs[1] + pairs[2]) / n - mean * mean;
+    *mean_out = mean;
+    *var_out = var;
+    if (n < TOURNAMENT_BATCH) return SPRT_CONTINUE;
+
+    // strategies that always split a pair (the same deterministic
+    // strategy on both sides) have no variance at all, keep a floor so
+    // that still reads as "no difference"
+    if (var < 1e-3) var = 1e-3;
+
+    double lower = log(TOURNAMENT_BETA / (1 - TOURNAMENT_ALPHA));
+    double upper = log((1 - TOURNAMENT_BETA) / TOURNAMENT_ALPHA);
+
+    // two one sided tests, A better by delta and B better by delta
+    double up = llr(n, mean, var, 0.5, 0.5 + TOURNAMENT_DELTA);
+    double down = llr(n, mean, var, 0.5, 0.5 - TOURNAMENT_DELTA);
+
+    if (up >= upper) return SPRT_A_STRONGER;
+    if (down >= upper) return SPRT_B_STRONGER;
+    if (up <= lower && down <= lower) return SPRT_NO_DIFFERENCE;
+    return SPRT_CONTINUE;
+}
+
+int tournament_run(
+    const char* const specs[2],
+    long              max_games,
+    uint64_t          seed  //
+) {
+    // check the names up front rather than in every thread
+    for (range(idx, 0, 2, 1)) {
+        strategy_t check;
+        if (!strategy_open(specs[idx], &check)) {
+            fprintf(stderr, "unknown strategy '%s', try:\n", specs[idx]);
+            strategy_list(stderr);
+            return 1;
+        }
+        strategy_close(&check);
+    }
+    if (max_games < 2) ohcrap("a tournament needs at least one pair");
+
+    tournament_t t = {
+        .specs = specs,
+        .seed = seed,
+        .max_pairs = max_games / 2,
+    };
+    t.dealer = dealer_start(seed, t.max_pairs);
+    t.batch_count = (t.max_pairs + TOURNAMENT_BATCH - 1) / TOURNAMENT_BATCH;
+    t.batches = calloc(t.batch_count, sizeof(batch_t));
+
+    int       threads = sim_threads();
+    pthread_t tids[threads];
+    double    start = sim_now();
+    for (range(idx, 0, threads, 1))
+        pthread_create(&tids[idx], NULL, &worker, &t);
+
+    // fold batches into the test in order as they finish
+    long   pairs[3] = {0};
+    sprt_t verdict = SPRT_CONTINUE;
+    double mean = 0.5, var = 0;
+    for (long idx = 0; idx < t.batch_count; idx++) {
+        long size = TOURNAMENT_BATCH;
+        if (t.max_pairs - idx * TOURNAMENT_BATCH < size)
+            size = t.max_pairs - idx * TOURNAMENT_BATCH;
+        while (atomic_load(&t.batches[idx].finished) < size)
+            nanosleep(&(struct timespec){.tv_nsec = 200000}, NULL);
+
+        for (range(k, 0, 3, 1)) pairs[k] += t.batches[idx].pairs[k];
+        verdict = sprt(pairs, &mean, &var);
+        if (verdict != SPRT_CONTINUE) break;
+    }
+    dealer_stop(t.dealer);
+    for (range(idx, 0, threads, 1)) pthread_join(tids[idx], NULL);
+    dealer_close(t.dealer);
+    double secs = sim_now() - start;
+
+    long   n = pairs[0] + pairs[1] + pairs[2];
+    double margin = n > 1 && var > 0 ? 1.96 * sqrt(var / n) : 0;
+    printf(
+        "%s vs %s: %li games (%li seat swapped pairs) on %i threads\n"
+        "%s win rate %.2f%% (95%% CI %.2f%% .. %.2f%%)\n"
+        "pairs won by %s: both %li, split %li, neither %li\n",
+        specs[0],
+        specs[1],
+        2 * n,
+        n,
+        threads,
+        specs[0],
+        100 * mean,
+        100 * (mean - margin),
+        100 * (mean + margin),
+        specs[0],
+        pairs[2],
+        pairs[1],
+        pairs[0]);
+
+    switch (verdict) {
+        case SPRT_A_STRONGER:
+            printf("verdict: %s is stronger\n", specs[0]);
+            break;
+        case SPRT_B_STRONGER:
+            printf("verdict: %s is stronger\n", specs[1]);
+            break;
+        case SPRT_NO_DIFFERENCE:
+            printf(
+                "verdict: no difference of %.0f%% or more\n",
+                100 * TOURNAMENT_DELTA);
+            break;
+        case SPRT_CONTINUE:
+            printf("verdict: undecided after the maximum number of games\n");
+            break;
+    }
+    printf("%.3fs, %.0f games/sec\n", secs, 2 * n / secs);
+
+    free(t.batches);
+    return 0;
+}
@@ -0,0 +1,57 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "sim.h"
+
+/** === [ Tournaments ] ===
+ *
+ * Games are played in pairs: both games of a pair use the same seed (so
+ * the same deck) with the strategies swapping seats, which cancels out
+ * most of the luck of the deal. A pair scores 0, 1/2, or 1 for A.
+ *
+ * After every batch of pairs a sequential probability ratio test (the
+ * normal approximation used for engine testing) checks whether A's
+ * score differs from 1/2 by at least TOURNAMENT_DELTA in either
+ * direction, so the run stops once the answer is clear instead of
+ * after a fixed number of games. Batches are folded into the test in
+ * order, so where it stops doesn't depend on the number of threads.
+ */
+
+#define TOURNAMENT_BATCH 64    // pairs handed to a worker at a time
+#define TOURNAMENT_DELTA 0.02  // the win rate difference worth detecting
+#define TOURNAMENT_ALPHA 0.05  // false positive rate
+#define TOURNAMENT_BETA  0.05  // false negative rate
+
+/**
+ * @brief run a tournament between two strategies and print the result
+ *
+ * @param specs the two strategies, as named on the command line
+ * @param max_games stop here even if the test hasn't decided
+ * @param seed the run's seed, pair i plays game i of the run's dealer
+ * @return int process exit code
+ */
+int tournament_run(
+    const char* const specs[2],
+    long              max_games,
+    uint64_t          seed);
@@ -0,0 +1,424 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "variant.h"
+#include "endgame.h"
+
+#define ALL_RANKS 0x1FFF
+#define MAX_TURNS 0xFFFF  // sim_result_t.turns can't count past this
+
+typedef sim_result_t (*variant_fn)(
+    const rules_t* const  rules,
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game);
+
+// the top card of the deck that's still in the game, CARD_IDX_NULL if
+// there's none (cards of booked ranks are passed over)
+static inline card_idx_t draw(
+    const deck_t* const deck,
+    int* const          remaining,
+    uint16_t            booked  //
+) {
+    while (*remaining > 0) {
+        card_idx_t card = deck->cards[--*remaining];
+        if (!(booked >> card_idx_slot(card) & 1)) return card;
+    }
+    return CARD_IDX_NULL;
+}
+
+// the rank slot a strategy asks for, see choose_slot in lockstep.c
+static int choose_slot(
+    lockstep_kind_t kind,
+    rng_t* const    rng,
+    card_mask_t     held,
+    const uint16_t  booked[2],
+    bool            solve  //
+) {
+    if (kind == LOCKSTEP_MOST) {
+        int best = 0, best_count = -1;
+        for (range(slot, 0, 13, 1)) {
+            int count = __builtin_popcountll(held & card_mask_rank(slot));
+            if (count >= best_count) {
+                best = slot;
+                best_count = count;
+            }
+        }
+        return best;
+    }
+
+    if (solve) {
+        uint8_t counts[13];
+        bool    either[13];
+        for (range(slot, 0, 13, 1)) {
+            counts[slot] = __builtin_popcountll(held & card_mask_rank(slot));
+            either[slot] = ((booked[0] | booked[1]) >> slot) & 1;
+        }
+        endgame_key_t key = endgame_key(
+            counts,
+            either,
+            __builtin_popcount(booked[0]),
+            __builtin_popcount(booked[1]));
+        return endgame_solve(key).best - RANK_2;
+    }
+
+    int nth = rng_below(rng, __builtin_popcountll(held));
+    return card_idx_slot(card_mask_nth(held, nth));
+}
+
+/**
+ * one game under the rules (hand, book, to_win), play_turn's logic as
+ * masks; inlined into every engine so they're constants there
+ *
+ * Only the ranks in `in_play` are dealt or drawn, the others are passed
+ * over like booked ones, and the game also ends once all of those are
+ * booked.
+ */
+static inline __attribute__((always_inline)) sim_result_t play_rules(
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game,
+    int                   hand,
+    int                   book,
+    int                   to_win,
+    uint16_t              in_play  //
+) {
+    bool standard = hand == RULES_HAND && book == RULES_BOOK &&
+                    to_win == RULES_TO_WIN && in_play == ALL_RANKS;
+    uint16_t out = ~in_play & ALL_RANKS;
+
+    deck_t deck;
+    sim_deal(&deck, seed, game, 1);
+    int         remaining = 52;
+    card_mask_t hands[2] = {0};
+    uint16_t    booked[2] = {0};
+    rng_t       rngs[2];
+    for (range(seat, 0, 2, 1)) {
+        for (range(_, 0, hand, 1))
+            hands[seat] |= (card_mask_t)1 << draw(&deck, &remaining, out);
+        rng_keyed(&rngs[seat], seed, game, SIM_STREAM_SEAT + seat);
+    }
+
+    sim_result_t result = {0};
+    int          seat = 0, streak = 0;
+    for (;;) {
+        if (++result.turns == MAX_TURNS) ohcrap("a variant game ran away");
+        uint16_t    either = booked[0] | booked[1] | out;
+        card_mask_t me = hands[seat];
+
+        // draw up an empty hand, or pass
+        if (me == 0) {
+            card_idx_t card = draw(&deck, &remaining, either);
+            if (card == CARD_IDX_NULL) {
+                seat = !seat;
+                streak = 0;
+                continue;
+            }
+            me = (card_mask_t)1 << card;
+        }
+
+        // the solver only knows the standard rules
+        int slot = choose_slot(
+            seats[seat],
+            &rngs[seat],
+            me,
+            (uint16_t[2]){booked[seat], booked[!seat]},
+            standard && remaining == 0);
+        card_mask_t want = card_mask_rank(slot);
+
+        card_mask_t taken = hands[!seat] & want;
+        hands[!seat] &= ~want;
+        me |= taken;
+
+        // books in the order play_turn makes them, the fished one first
+        int  made[2], made_count = 0;
+        bool extra = false;
+        if (taken == 0) {
+            card_idx_t card = draw(&deck, &remaining, either);
+            if (card != CARD_IDX_NULL) {
+                card_mask_t top = (card_mask_t)1 << card;
+                card_mask_t top_rank = card_mask_rank(card_idx_slot(card));
+                extra = (top & want) != 0;
+                if (!extra &&
+                    __builtin_popcountll(me & top_rank) + 1 >= book) {
+                    me &= ~top_rank;
+                    made[made_count++] = card_idx_slot(card);
+                } else {
+                    me |= top;
+                }
+            }
+        }
+        if (__builtin_popcountll(me & want) >= book) {
+            me &= ~want;
+            made[made_count++] = slot;
+        }
+        hands[seat] = me;
+
+        int winner = -1;
+        for (range(idx, 0, made_count, 1)) {
+            // the rest of the rank leaves the game with it
+            booked[seat] |= 1 << made[idx];
+            hands[!seat] &= ~card_mask_rank(made[idx]);
+            extra = true;
+
+            int mine = __builtin_popcount(booked[seat]);
+            int theirs = __builtin_popcount(booked[!seat]);
+            if (mine >= to_win) winner = seat;
+            // most books, with an even number of ranks in play a tie
+            // goes to the mover and the books show it was one
+            else if ((booked[0] | booked[1]) == in_play)
+                winner = mine > theirs ? seat : !seat;
+            if (winner >= 0) break;
+        }
+
+        if (result.first_book == 0 && booked[seat] != 0)
+            result.first_book = result.turns;
+        if (winner >= 0) {
+            seat = winner;
+            break;
+        }
+        if (extra) {
+            if (++streak > result.streak) result.streak = streak;
+        } else {
+            streak = 0;
+            seat = !seat;
+        }
+    }
+
+    result.winner = seat;
+    for (range(idx, 0, 2, 1)) {
+        result.books[idx] = __builtin_popcount(booked[idx]);
+        result.booked[idx] = booked[idx];
+    }
+    return result;
+}
+
+// one engine per listed variant, with its rules as literals
+#define ENGINE(name, hand, book, to_win)                          \
+    static sim_result_t play_##name(                              \
+        const rules_t* const  rules,                              \
+        const lockstep_kind_t seats[2],                           \
+        uint64_t              seed,                               \
+        uint64_t              game) {                             \
+        return play_rules(                                        \
+            seats, seed, game, hand, book, to_win, ALL_RANKS);    \
+    }
+VARIANT_LIST(ENGINE)
+#undef ENGINE
+
+// and one taking them at run time, for everything else
+static sim_result_t play_any(
+    const rules_t* const  rules,
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game  //
+) {
+    return play_rules(
+        seats,
+        seed,
+        game,
+        rules->hand,
+        rules->book,
+        rules->to_win,
+        ALL_RANKS);
+}
+
+typedef struct {
+    const char* name;
+    rules_t     rules;
+    variant_fn  play;
+} variant_t;
+
+#define ENTRY(name, hand, book, to_win) \
+    {#name, {hand, book, to_win}, &play_##name},
+static const variant_t variants[] = {VARIANT_LIST(ENTRY)};
+#undef ENTRY
+
+#define VARIANT_COUNT (sizeof(variants) / sizeof(variants[0]))
+
+static variant_fn engine_for(const rules_t* const rules) {
+    for (range(idx, 0, VARIANT_COUNT, 1))
+        if (variants[idx].rules.hand == rules->hand &&
+            variants[idx].rules.book == rules->book &&
+            variants[idx].rules.to_win == rules->to_win)
+            return variants[idx].play;
+    return &play_any;
+}
+
+err_t variant_valid(const rules_t* const rules) {
+    return rules->hand >= 1 && rules->hand <= 26 && rules->book >= 2 &&
+           rules->book <= 4 && rules->to_win >= 1 && rules->to_win <= 13;
+}
+
+sim_result_t variant_play(
+    const rules_t* const  rules,
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game  //
+) {
+    if (!variant_valid(rules)) ohcrap("those rules can't be played");
+    return engine_for(rules)(rules, seats, seed, game);
+}
+
+sim_result_t variant_play_ranks(
+    const rules_t* const  rules,
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game,
+    int                   ranks  //
+) {
+    if (!variant_valid(rules) || ranks < 1 || ranks > 13 ||
+        2 * rules->hand > ranks * 4)
+        ohcrap("those rules can't be played");
+    return play_rules(
+        seats,
+        seed,
+        game,
+        rules->hand,
+        rules->book,
+        rules->to_win,
+        (1 << ranks) - 1);
+}
+
+static bool same_result(const sim_result_t* a, const sim_result_t* b) {
+    return a->winner == b->winner && a->books[0] == b->books[0] &&
+           a->books[1] == b->books[1] && a->turns == b->turns &&
+           a->booked[0] == b->booked[0] && a->booked[1] == b->booked[1] &&
+           a->first_book == b->first_book && a->streak == b->streak;
+}
+
+// play the games with one engine, returning the games per second
+static double sweep_with(
+    variant_fn            play,
+    const rules_t* const  rules,
+    const lockstep_kind_t kinds[2],
+    long                  games,
+    uint64_t              seed,
+    sim_result_t* const   results  //
+) {
+    const lockstep_kind_t seats[2][2] = {
+        {kinds[0], kinds[1]},
+        {kinds[1], kinds[0]},
+    };
+    double start = sim_now();
+    for (long game = 0; game < games; game++)
+        results[game] = play(rules, seats[game & 1], seed, game);
+    return games / (sim_now() - start);
+}
+
+int variant_sweep(
+    const char* const specs[2],
+    long              games,
+    uint64_t          seed  //
+) {
+    lockstep_kind_t kinds[2];
+    strategy_t      opened[2];
+    for (range(idx, 0, 2, 1)) {
+        if (!lockstep_kind(specs[idx], &kinds[idx])) {
+            fprintf(
+                stderr,
+                "variants can only be played by random and most, not "
+                "'%s'\n",
+                specs[idx]);
+            return 1;
+        }
+        strategy_open(specs[idx], &opened[idx]);
+    }
+    if (games <= 0) ohcrap("the number of games must be positive");
+
+    sim_result_t* results = calloc(games, sizeof(sim_result_t));
+    sim_result_t* generic = calloc(games, sizeof(sim_result_t));
+    long          differ = 0;  // between the two kinds of engine
+
+    printf(
+        "%-16s %4s %4s %6s %7s %7s %6s %11s %11s\n",
+        "variant",
+        "hand",
+        "book",
+        "to win",
+        "A wins",
+        "seat 0",
+        "turns",
+        "specialized",
+        "generic");
+    for (range(idx, 0, VARIANT_COUNT, 1)) {
+        const variant_t* variant = &variants[idx];
+        double           fast = sweep_with(
+            variant->play, &variant->rules, kinds, games, seed, results);
+        double slow = sweep_with(
+            &play_any, &variant->rules, kinds, games, seed, generic);
+
+        long a_wins = 0, seat0_wins = 0, turns = 0;
+        for (long game = 0; game < games; game++) {
+            a_wins += results[game].winner == (game & 1);
+            seat0_wins += results[game].winner == 0;
+            turns += results[game].turns;
+            differ += !same_result(&results[game], &generic[game]);
+        }
+        printf(
+            "%-16s %4i %4i %6i %6.2f%% %6.2f%% %6.1f %11.0f %11.0f\n",
+            variant->name,
+            variant->rules.hand,
+            variant->rules.book,
+            variant->rules.to_win,
+            100.0 * a_wins / games,
+            100.0 * seat0_wins / games,
+            (double)turns / games,
+            fast,
+            slow);
+    }
+
+    // the standard variant is the real game
+    const strategy_t* seats[2][2] = {
+        {&opened[0], &opened[1]},
+        {&opened[1], &opened[0]},
+    };
+    const rules_t standard = {RULES_HAND, RULES_BOOK, RULES_TO_WIN};
+    sweep_with(
+        engine_for(&standard), &standard, kinds, games, seed, results);
+    long matched = 0;
+    for (long game = 0; game < games; game++) {
+        sim_result_t expected = sim_play(seats[game & 1], seed, game);
+        matched += same_result(&expected, &results[game]);
+    }
+    printf(
+        "games/sec per engine, the generic one takes the rules at run "
+        "time\n"
+        "specialized vs generic engines: %li games differ %s\n"
+        "standard rules vs sim_play: %li of %li games match %s\n",
+        differ,
+        differ == 0 ? "ok" : "DIFFERENT",
+        matched,
+        games,
+        matched == games ? "ok" : "DIFFERENT");
+
+    strategy_close(&opened[0]);
+    strategy_close(&opened[1]);
+    free(results);
+    free(generic);
+    return differ != 0 || matched != games;
+}
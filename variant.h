@@ -0,0 +1,93 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "lockstep.h"
+#include "rules.h"
+
+/** === [ Rule variants ] ===
+ *
+ * Headless games under other rules (see rules_t), for sweeping how the
+ * rules change the game. One game is played at a time with hands as
+ * card_mask_t, by the built in strategies the lockstep engine knows.
+ *
+ * The engine is a single always inlined function taking the rules as
+ * arguments, and VARIANT_LIST stamps out a copy of it per listed
+ * variant with the rules as literals, so each copy has its deal size,
+ * book size and win check folded into constants. variant_play picks
+ * the copy for the rules it's given, or a copy taking them at run time
+ * for rules that aren't listed.
+ *
+ * Under the standard rules it plays exactly the games sim_play does.
+ * Under others the "random" strategy asks at random in the endgame too,
+ * since the endgame solver only knows the standard rules.
+ */
+
+// name, hand, book, to_win
+#define VARIANT_LIST(X)        \
+    X(standard, 7, 4, 7)       \
+    X(five_card_deal, 5, 4, 7) \
+    X(nine_card_deal, 9, 4, 7) \
+    X(first_to_five, 7, 4, 5)  \
+    X(every_book, 7, 4, 13)    \
+    X(triples, 7, 3, 7)        \
+    X(pairs, 7, 2, 7)
+
+/**
+ * @brief check a set of rules can be played
+ */
+err_t variant_valid(const rules_t* const rules);
+
+/**
+ * @brief play game `game` of a run under the rules, seat 0 moves first
+ */
+sim_result_t variant_play(
+    const rules_t* const  rules,
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game);
+
+/**
+ * @brief variant_play on a deck cut down to the lowest `ranks` ranks
+ * (2s up), ending when all of them are booked if nobody got to `to_win`
+ * first; a game whose books are split evenly is a draw whatever the
+ * winner says
+ *
+ * For checking the enumerator (see enumerate.h) against an engine that
+ * shares none of its code.
+ */
+sim_result_t variant_play_ranks(
+    const rules_t* const  rules,
+    const lockstep_kind_t seats[2],
+    uint64_t              seed,
+    uint64_t              game,
+    int                   ranks);
+
+/**
+ * @brief play `games` games (odd games swap the seats) under every
+ * listed variant and report how the rules change them, and check the
+ * standard variant against sim_play
+ *
+ * @return int process exit code, 1 if the standard variant differs
+ */
+int variant_sweep(const char* const specs[2], long games, uint64_t seed);
@@ -0,0 +1,373 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+#include <stdatomic.h>
+
+#include "weights.h"
+#include "strategy.h"
+#include "sim.h"
+#include "endgame.h"
+
+#define WEIGHTS_CHUNK 64  // games a worker takes at a time
+
+static const char* const feature_names[WEIGHTS_FEATURES] = {
+    "held",
+    "chance",
+    "asked",
+    "held_deck",
+    "chance_deck",
+};
+
+// scale to unit length, which doesn't change any decision
+static weights_t unit(weights_t weights) {
+    double length = 0;
+    for (range(idx, 0, WEIGHTS_FEATURES, 1))
+        length += weights.w[idx] * weights.w[idx];
+    length = sqrt(length);
+    if (length > 0)
+        for (range(idx, 0, WEIGHTS_FEATURES, 1)) weights.w[idx] /= length;
+    return weights;
+}
+
+weights_t* weights_open(const char* const path) {
+    FILE* file = fopen(path, "r");
+    if (file == NULL) ohcrap("unable to open the weights file");
+
+    weights_t* weights = calloc(1, sizeof(weights_t));
+    bool       found[WEIGHTS_FEATURES] = {false};
+    char       line[128];
+    while (fgets(line, sizeof(line), file) != NULL) {
+        char   name[32];
+        double value;
+        if (line[0] == '#' || sscanf(line, "%31s %lf", name, &value) != 2)
+            continue;
+        for (range(idx, 0, WEIGHTS_FEATURES, 1))
+            if (strcmp(name, feature_names[idx]) == 0) {
+                weights->w[idx] = value;
+                found[idx] = true;
+            }
+    }
+    fclose(file);
+
+    for (range(idx, 0, WEIGHTS_FEATURES, 1))
+        if (!found[idx]) ohcrap("the weights file is missing a feature");
+    return weights;
+}
+
+void weights_close(weights_t* const weights) { free(weights); }
+
+static rank_t best_ask(const player_t* const player, const weights_t* w) {
+    const belief_t* seen = &player->opponent->seen;
+    card_mask_t     mine = hand_mask(&player->hand);
+    double          left = player->deck->remaining / 52.0;
+
+    rank_t best = RANK_NULL;
+    double best_score = -INFINITY;
+    for (range(slot, 0, 13, 1)) {
+        int held = __builtin_popcountll(mine & card_mask_rank(slot));
+        if (held == 0) continue;
+
+        double chance = belief_chance(player, slot + RANK_2);
+        double score = w->w[0] * held + w->w[1] * chance +
+                       w->w[2] * (seen->asked >> slot & 1) +
+                       w->w[3] * held * left + w->w[4] * chance * left;
+        if (score > best_score) {
+            best = slot + RANK_2;
+            best_score = score;
+        }
+    }
+    return best;
+}
+
+rank_t weights_read_rank(player_t* player) {
+    rank_t rank;
+    if (player->opponent == NULL || player->deck == NULL)
+        rank = belief_best_ask(player);
+    else if (player->deck->remaining == 0 && player->hand.length != 0)
+        rank = endgame_solve(endgame_key_for(player)).best;
+    else
+        rank = best_ask(player, player->ctx);
+
+    game_printf(
+        "%s is looking for Rank: " ESC_CYN "%s" ESC_RST "\n",
+        player->name,
+        rank_as_str(rank));
+    return rank;
+}
+
+/* === [ Tuning ] === */
+
+static const strategy_def_t candidate_def = {
+    .name = "candidate",
+    .read_rank = &weights_read_rank,
+};
+
+typedef struct {
+    const char*      opponent;
+    uint64_t         seed;
+    const weights_t* candidates;
+    _Atomic long*    wins;  // per candidate
+    long             first_game, games;
+    _Atomic long     next;  // candidate * games + game
+    long             end;
+} tuning_t;
+
+static void* tune_worker(void* arg) {
+    tuning_t*  tuning = arg;
+    strategy_t opponent;
+    if (!strategy_open(tuning->opponent, &opponent))
+        ohcrap("unknown strategy");
+
+    for (;;) {
+        long start = atomic_fetch_add(&tuning->next, WEIGHTS_CHUNK);
+        if (start >= tuning->end) break;
+        long stop = start + WEIGHTS_CHUNK;
+        if (stop > tuning->end) stop = tuning->end;
+
+        for (long item = start; item < stop; item++) {
+            long       idx = item / tuning->games;
+            long       game = tuning->first_game + item % tuning->games;
+            strategy_t me = {
+                .def = &candidate_def,
+                .ctx = (void*)&tuning->candidates[idx],
+            };
+
+            // the candidate moves first in even games
+            const strategy_t* seats[2][2] = {
+                {&me, &opponent},
+                {&opponent, &me},
+            };
+            sim_result_t result =
+                sim_play(seats[game & 1], tuning->seed, game);
+            if (result.winner == (game & 1))
+                atomic_fetch_add(&tuning->wins[idx], 1);
+        }
+    }
+
+    strategy_close(&opponent);
+    endgame_release();
+    return NULL;
+}
+
+/**
+ * @brief play every candidate through games first_game .. first_game +
+ * games - 1 of the run, into wins
+ */
+static void evaluate(
+    tuning_t*        tuning,
+    const weights_t* candidates,
+    int              count,
+    long             first_game,
+    long*            wins  //
+) {
+    _Atomic long counts[count];
+    for (range(idx, 0, count, 1)) atomic_init(&counts[idx], 0);
+    tuning->candidates = candidates;
+    tuning->wins = counts;
+    tuning->first_game = first_game;
+    tuning->end = count * tuning->games;
+    atomic_init(&tuning->next, 0);
+
+    int       threads = sim_threads();
+    pthread_t tids[threads];
+    for (range(idx, 0, threads, 1))
+        pthread_create(&tids[idx], NULL, &tune_worker, tuning);
+    for (range(idx, 0, threads, 1)) pthread_join(tids[idx], NULL);
+
+    for (range(idx, 0, count, 1)) wins[idx] = atomic_load(&counts[idx]);
+}
+
+// a standard normal deviate
+static double gaussian(rng_t* const rng) {
+    double u = ((rng_next(rng) >> 11) + 1) * 0x1p-53;
+    double v = (rng_next(rng) >> 11) * 0x1p-53;
+    return sqrt(-2 * log(u)) * cos(2 * M_PI * v);
+}
+
+static err_t write_weights(
+    const char* const path,
+    const weights_t*  weights,
+    const char* const opponent  //
+) {
+    FILE* file = fopen(path, "w");
+    if (file == NULL) return ERROR;
+    fprintf(file, "# heuristic weights, tuned against %s\n", opponent);
+    for (range(idx, 0, WEIGHTS_FEATURES, 1))
+        fprintf(file, "%s %.9f\n", feature_names[idx], weights->w[idx]);
+    return fclose(file) == 0 ? SUCCESS : ERROR;
+}
+
+int weights_tune(
+    const char* const path,
+    const char* const opponent,
+    long              games,
+    int               generations,
+    uint64_t          seed  //
+) {
+    strategy_t check;
+    if (!strategy_open(opponent, &check)) {
+        fprintf(stderr, "unknown strategy '%s', try:\n", opponent);
+        strategy_list(stderr);
+        return 1;
+    }
+    strategy_close(&check);
+    if (games <= 0 || generations <= 0)
+        ohcrap("the games and generations must be positive");
+
+    // the separable CMA-ES constants, for WEIGHTS_FEATURES dimensions
+    const int n = WEIGHTS_FEATURES, mu = WEIGHTS_LAMBDA / 2;
+    double    recomb[mu], recomb_sum = 0, mu_eff = 0;
+    for (range(idx, 0, mu, 1)) {
+        recomb[idx] = log(mu + 0.5) - log(idx + 1);
+        recomb_sum += recomb[idx];
+    }
+    for (range(idx, 0, mu, 1)) {
+        recomb[idx] /= recomb_sum;
+        mu_eff += recomb[idx] * recomb[idx];
+    }
+    mu_eff = 1 / mu_eff;
+
+    double c_sigma = (mu_eff + 2) / (n + mu_eff + 5);
+    double d_sigma =
+        1 + 2 * fmax(0, sqrt((mu_eff - 1) / (n + 1)) - 1) + c_sigma;
+    double c_c = (4 + mu_eff / n) / (n + 4 + 2 * mu_eff / n);
+    double c_1 = 2 / ((n + 1.3) * (n + 1.3) + mu_eff) * (n + 2) / 3;
+    double c_mu = fmin(
+        1 - c_1,
+        2 * (mu_eff - 2 + 1 / mu_eff) / ((n + 2) * (n + 2) + mu_eff) *
+            (n + 2) / 3);
+    double expected_norm =
+        sqrt(n) * (1 - 1.0 / (4 * n) + 1.0 / (21 * n * n));
+
+    // start from the belief strategy, ties broken by cards held
+    weights_t mean = unit((weights_t){{0.1, 1, 0, 0, 0}});
+    double    sigma = WEIGHTS_SIGMA, spread[WEIGHTS_FEATURES];
+    double    path_sigma[WEIGHTS_FEATURES] = {0};
+    double    path_c[WEIGHTS_FEATURES] = {0};
+    for (range(idx, 0, n, 1)) spread[idx] = 1;
+
+    rng_t rng;
+    rng_seed(&rng, seed);
+    tuning_t tuning = {.opponent = opponent, .seed = seed, .games = games};
+
+    for (range(generation, 0, generations, 1)) {
+        // the last candidate is the mean itself, to report on
+        weights_t candidates[WEIGHTS_LAMBDA + 1];
+        double    z[WEIGHTS_LAMBDA][WEIGHTS_FEATURES];
+        double    y[WEIGHTS_LAMBDA][WEIGHTS_FEATURES];
+        for (range(k, 0, WEIGHTS_LAMBDA, 1)) {
+            for (range(idx, 0, n, 1)) {
+                z[k][idx] = gaussian(&rng);
+                y[k][idx] = sqrt(spread[idx]) * z[k][idx];
+                candidates[k].w[idx] = mean.w[idx] + sigma * y[k][idx];
+            }
+            candidates[k] = unit(candidates[k]);
+        }
+        candidates[WEIGHTS_LAMBDA] = mean;
+
+        // the same games for every candidate, every generation
+        long wins[WEIGHTS_LAMBDA + 1];
+        evaluate(&tuning, candidates, WEIGHTS_LAMBDA + 1, 0, wins);
+
+        // rank the candidates, most wins first (stable, so a tie goes
+        // the same way every run)
+        int order[WEIGHTS_LAMBDA];
+        for (range(k, 0, WEIGHTS_LAMBDA, 1)) {
+            int at = k;
+            for (; at > 0 && wins[order[at - 1]] < wins[k]; at--)
+                order[at] = order[at - 1];
+            order[at] = k;
+        }
+
+        double y_w[WEIGHTS_FEATURES] = {0}, z_w[WEIGHTS_FEATURES] = {0};
+        for (range(rank, 0, mu, 1))
+            for (range(idx, 0, n, 1)) {
+                y_w[idx] += recomb[rank] * y[order[rank]][idx];
+                z_w[idx] += recomb[rank] * z[order[rank]][idx];
+            }
+
+        double norm = 0;
+        for (range(idx, 0, n, 1)) {
+            mean.w[idx] += sigma * y_w[idx];
+            path_sigma[idx] = (1 - c_sigma) * path_sigma[idx] +
+                              sqrt(c_sigma * (2 - c_sigma) * mu_eff) *
+                                  z_w[idx];
+            path_c[idx] = (1 - c_c) * path_c[idx] +
+                          sqrt(c_c * (2 - c_c) * mu_eff) * y_w[idx];
+
+            double rank_mu = 0;
+            for (range(rank, 0, mu, 1))
+                rank_mu += recomb[rank] * y[order[rank]][idx] *
+                           y[order[rank]][idx];
+            spread[idx] = (1 - c_1 - c_mu) * spread[idx] +
+                          c_1 * path_c[idx] * path_c[idx] + c_mu * rank_mu;
+            norm += path_sigma[idx] * path_sigma[idx];
+        }
+        sigma *= exp(c_sigma / d_sigma * (sqrt(norm) / expected_norm - 1));
+
+        // only the direction matters, so keep the mean at unit length
+        // and the step size relative to it
+        double length = 0;
+        for (range(idx, 0, n, 1)) length += mean.w[idx] * mean.w[idx];
+        sigma /= sqrt(length);
+        mean = unit(mean);
+
+        printf(
+            "generation %i: mean won %.2f%%, best candidate %.2f%%, "
+            "step %.3f\n",
+            generation + 1,
+            100.0 * wins[WEIGHTS_LAMBDA] / games,
+            100.0 * wins[order[0]] / games,
+            sigma);
+    }
+
+    // the tuned weights against the start, on games none of them saw
+    weights_t finals[2] = {mean, unit((weights_t){{0.1, 1, 0, 0, 0}})};
+    long      check_wins[2];
+    tuning.games = games * WEIGHTS_CHECK;
+    evaluate(&tuning, finals, 2, games, check_wins);
+
+    const char* labels[2] = {"tuned", "start"};
+    for (range(idx, 0, 2, 1)) {
+        double rate = (double)check_wins[idx] / tuning.games;
+        printf(
+            "%s weights won %.2f%% (+- %.2f%%) of %li fresh games vs %s\n",
+            labels[idx],
+            100 * rate,
+            196 * sqrt(rate * (1 - rate) / tuning.games),
+            tuning.games,
+            opponent);
+    }
+    for (range(idx, 0, n, 1))
+        printf("  %-12s %9.5f\n", feature_names[idx], mean.w[idx]);
+
+    if (!write_weights(path, &mean, opponent)) {
+        fprintf(stderr, "couldn't write '%s'\n", path);
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,92 @@
+// Copyright 2022 Jonah 'Jay' Yolles-Murphy (TG-Techie)
+//
+// Permission is hereby granted, free of charge, to any person
+// obtaining a copy of this software and associated documentation
+// files (the "Software"), to deal in the Software without
+// restriction, including without limitation the rights to use, copy,
+// modify, merge, publish, distribute, sublicense, and/or sell copies
+// of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions:
+//
+//  The above copyright notice and this permission notice shall be
+//  included in all copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND,
+// EXPRESS OR IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF
+// MERCHANTABILITY, FITNESS FOR A PARTICULAR PURPOSE AND
+// NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR COPYRIGHT HOLDERS
+// BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER IN AN
+// ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+// CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+
+#pragma once
+
+#include "player.h"
+
+/** === [ Weighted heuristic ] ===
+ *
+ * A strategy that scores every rank in its hand with a weighted sum of
+ * a few features and asks for the best one (the lowest rank on a tie),
+ * solving the endgame like the compy once the deck is out:
+ *
+ *   held          cards of the rank in hand
+ *   chance        the chance the opponent holds it, see belief_chance
+ *   asked         1 if the opponent asked for it and still holds it
+ *   held_deck     held, times the fraction of the deck left
+ *   chance_deck   chance, times the fraction of the deck left
+ *
+ * The deck terms let a weight change as the game goes on: only the
+ * differences between ranks matter, so the deck size on its own (the
+ * same for every rank) couldn't change a decision. Scaling every weight
+ * by the same positive amount doesn't either, so they're kept to unit
+ * length.
+ *
+ * The weights come from a text file of "<feature> <weight>" lines (see
+ * the "weights:<file>" strategy), which --tune writes. It searches for
+ * the weights that win the most against an opponent with a separable
+ * CMA-ES: each generation samples WEIGHTS_LAMBDA candidates around the
+ * current mean, plays them all in parallel, and moves the mean, step
+ * size and per weight spread towards the best half. Every candidate of
+ * every generation plays the same games (the same game numbers of the
+ * same run, so the same decks and the same opponent moves for the same
+ * asks), so candidates are compared on common random numbers and the
+ * luck of the deal mostly cancels out of the differences.
+ */
+
+#define WEIGHTS_FEATURES 5
+#define WEIGHTS_LAMBDA   12    // candidates per generation
+#define WEIGHTS_SIGMA    0.3   // the first step size
+#define WEIGHTS_CHECK    4     // the final weights are checked over this
+                               // many times the games, on fresh deals
+
+typedef struct {
+    double w[WEIGHTS_FEATURES];
+} weights_t;
+
+/**
+ * @brief read a weights file
+ *
+ * @exception exits if it can't be read or a feature is missing
+ */
+weights_t* weights_open(const char* const path);
+
+void weights_close(weights_t* const);
+
+/**
+ * @brief read_rank for the weights_t in the player's ctx
+ */
+rank_t weights_read_rank(player_t* player);
+
+/**
+ * @brief tune weights against `opponent` and write them to `path`
+ *
+ * @param games games each candidate plays (seats swapping every game)
+ * @return int process exit code
+ */
+int weights_tune(
+    const char* const path,
+    const char* const opponent,
+    long              games,
+    int               generations,
+    uint64_t          seed);